@@ -0,0 +1,76 @@
+#!/bin/sh
+# Checks onlinefdr-stream: a stream answered over a socket, and one stopped
+# and resumed from its checkpoint, must give the same replies as one read
+# from standard input without interruption, and forecasts must give the
+# levels the tests then get. Then runs registry-load, whose
+# streams appended from several threads must match serial runs. Run from
+# this directory.
+set -e
+
+CXX=${CXX:-c++}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+$CXX -std=c++17 -O2 -I../include onlinefdr-stream.cpp -o "$dir/stream"
+$CXX -std=c++17 -O2 onlinefdr-client.cpp -o "$dir/client"
+$CXX -std=c++17 -O2 -pthread -I../include registry-load.cpp -o "$dir/load"
+
+# p-values with a few signals, on a default stream and a named one
+awk 'BEGIN {
+	srand(1)
+	print "open s ADDIS alpha=0.1"
+	for (i = 1; i <= 4000; i++) {
+		p = (i % 50 == 0) ? rand() / 1e5 : rand()
+		if (i % 2) print p; else print "s", p
+	}
+}' > "$dir/requests"
+head -n 2001 "$dir/requests" > "$dir/first"
+tail -n +2002 "$dir/requests" > "$dir/second"
+
+"$dir/stream" SAFFRON alpha=0.05 < "$dir/requests" > "$dir/expected"
+grep -q ' 1$' "$dir/expected"
+
+"$dir/stream" --socket "$dir/sock" SAFFRON alpha=0.05 &
+pid=$!
+while [ ! -S "$dir/sock" ]; do sleep 0.1; done
+"$dir/client" "$dir/sock" < "$dir/requests" > "$dir/socket"
+kill $pid
+wait $pid
+cmp "$dir/expected" "$dir/socket"
+
+"$dir/stream" --checkpoint "$dir/state" --every 100 SAFFRON alpha=0.05 \
+	< "$dir/first" > "$dir/resumed"
+"$dir/stream" --checkpoint "$dir/state" SAFFRON alpha=0.05 \
+	< "$dir/second" >> "$dir/resumed"
+cmp "$dir/expected" "$dir/resumed"
+
+# forecasts, planned and not, must give the levels the tests then get
+for proc in SAFFRON LORD "LORD version=discard" "ADDIS lambda=0.25 tau=0.5"; do
+	{
+		echo "open f $proc"
+		grep -v ' ' "$dir/first" | sed 's/^/f /'
+		echo "forecast f 6 2 5"
+		echo "forecast f 6 2 5"
+		printf 'f 1\nf 0\nf 1\nf 1\nf 0\nf 1\n'
+	} | "$dir/stream" > "$dir/forecast"
+	tail -n 8 "$dir/forecast" | awk '
+		NR == 1 { split($0, planned) }
+		NR == 2 { split($0, again) }
+		NR > 2 && ($1 != planned[NR-2] || $1 != again[NR-2]) { exit 1 }'
+done
+
+# a candidate that is not selected is refused, as by procedureSpec(), and
+# the streams already open go on
+printf 'open a ADDIS lambda=0.9\na 0.7\nopen b ADDIS_spending tau=0.25\n0.7\n' |
+	"$dir/stream" SAFFRON > "$dir/errors"
+printf '%s\n' "error lambda must be between 0 and tau." "error No stream 'a'." \
+	"error lambda must be less than tau." > "$dir/expected-errors"
+head -n 3 "$dir/errors" | cmp - "$dir/expected-errors"
+[ $(wc -l < "$dir/errors") -eq 4 ]
+if "$dir/stream" ADDIS lambda=0.9 < /dev/null 2> /dev/null; then
+	exit 1
+fi
+
+echo "onlinefdr-stream: OK"
+
+"$dir/load" 8 2000 500
@@ -0,0 +1,63 @@
+// onlinefdr-client: a minimal client of onlinefdr-stream --socket, for
+// testing. Sends the lines of standard input one at a time, waiting for
+// each reply, prints the replies and reports the mean round trip on
+// standard error. Build it with
+//
+//   c++ -std=c++17 -O2 onlinefdr-client.cpp -o onlinefdr-client
+//
+// Usage: onlinefdr-client PATH < requests
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+	if (argc != 2) {
+		std::fprintf(stderr, "usage: onlinefdr-client PATH < requests\n");
+		return 2;
+	}
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	std::strncpy(addr.sun_path, argv[1], sizeof addr.sun_path - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof addr) < 0) {
+		std::perror("onlinefdr-client");
+		return 1;
+	}
+
+	std::string line, reply;
+	double total = 0;
+	long long requests = 0;
+	while (std::getline(std::cin, line)) {
+		line += '\n';
+		auto start = std::chrono::steady_clock::now();
+		if (write(fd, line.data(), line.size()) != (ssize_t)line.size()) {
+			std::perror("onlinefdr-client");
+			return 1;
+		}
+		// empty lines get no reply
+		if (line.find_first_not_of(" \t\r\n") == std::string::npos)
+			continue;
+		reply.clear();
+		char c;
+		while (read(fd, &c, 1) == 1 && c != '\n')
+			reply += c;
+		total += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		requests++;
+		std::printf("%s\n", reply.c_str());
+	}
+	close(fd);
+
+	if (requests)
+		std::fprintf(stderr, "%lld requests, %.1f us per round trip\n", requests,
+			1e6 * total / requests);
+	return 0;
+}
@@ -0,0 +1,476 @@
+// onlinefdr-stream: keeps online testing procedures open as named streams
+// and answers each p-value with its level and decision as it arrives, on
+// standard input or a local Unix socket. Needs a POSIX system. Build it
+// from the installed package (or the sources) with
+//
+//   c++ -std=c++17 -O2 -I../include onlinefdr-stream.cpp -o onlinefdr-stream
+//
+// Usage:
+//
+//   onlinefdr-stream [--socket PATH] [--binary] [--checkpoint FILE]
+//                    [--every N] [PROCEDURE [key=value ...]]
+//
+// The procedure on the command line opens the default stream, written as
+// in onlineFDR/options.h, e.g. "SAFFRON alpha=0.05 lambda=0.5". Requests
+// are lines, each answered by one line:
+//
+//   open NAME PROCEDURE [key=value ...]   ok
+//   NAME PVAL                             ALPHAI R
+//   PVAL                                  the same on the default stream
+//   close NAME                            ok
+//   checkpoint                            ok
+//   forecast NAME K [J ...]               ALPHAI ...
+//
+// where R is 1 if the hypothesis is rejected and 0 otherwise. A forecast
+// gives the levels the next K tests of a stream (- for the default one)
+// would get if tests J, ... among them (counted from 1) were rejected and
+// the others were null, without testing them. The stream then keeps what
+// forecasts of up to K tests need, so these take time independent of its
+// history. A request
+// that cannot be served is answered by "error MESSAGE". With --binary the
+// requests are p-values for the default stream as native 8-byte doubles,
+// and each reply is the level as a double followed by the byte 1 or 0 (or
+// NaN and 255 for a p-value outside [0, 1]).
+//
+// Replies are written as soon as the input read so far has been answered.
+// With --socket, clients connect to PATH and share the streams; requests
+// are served in the order they are read. With --checkpoint, the streams are
+// loaded from FILE at start and saved to it every N tests (100000 by
+// default), on the checkpoint request and on exit.
+
+#include <onlineFDR/options.h>
+#include <onlineFDR/procedures.h>
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+volatile std::sig_atomic_t stopping = 0;
+
+void on_signal(int) {
+	stopping = 1;
+}
+
+struct Stream {
+	std::string spec;
+	std::unique_ptr<onlinefdr::Procedure> proc;
+};
+
+class Server {
+public:
+	Server(const std::string &checkpoint, long long every) : checkpoint(checkpoint),
+		every(every) {}
+
+	// Throws std::invalid_argument if the stream cannot be opened.
+	void open(const std::string &name, const std::string &spec) {
+		if (name == "open" || name == "close" || name == "checkpoint" || name == "forecast")
+			throw std::invalid_argument("'" + name + "' cannot name a stream.");
+		if (streams.count(name))
+			throw std::invalid_argument("Stream '" + name + "' is already open.");
+		// the gamma sequence is closed-form, so the procedure needs no table
+		std::vector<std::string> words = onlinefdr::split_words(spec);
+		Stream s;
+		s.proc = onlinefdr::make_procedure(onlinefdr::parse_spec(words));
+		for (const std::string &w : words)
+			s.spec += (s.spec.empty() ? "" : " ") + w;
+		streams[name] = std::move(s);
+	}
+
+	bool has(const std::string &name) const {
+		return streams.count(name) > 0;
+	}
+
+	const std::string &spec(const std::string &name) const {
+		return streams.at(name).spec;
+	}
+
+	// Answers one request line, appending the reply to out.
+	void line(const char *b, const char *e, std::string &out) {
+		while (b < e && (*b == ' ' || *b == '\t'))
+			b++;
+		while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+			e--;
+		if (b == e)
+			return;
+
+		const char *sp = b;
+		while (sp < e && *sp != ' ' && *sp != '\t')
+			sp++;
+		std::string first(b, sp);
+		const char *rest = sp;
+		while (rest < e && (*rest == ' ' || *rest == '\t'))
+			rest++;
+
+		try {
+			if (rest == e) {
+				if (first == "checkpoint") {
+					save();
+					out += "ok\n";
+				} else {
+					test("-", first, out);
+				}
+			} else if (first == "open") {
+				const char *n = rest;
+				while (n < e && *n != ' ' && *n != '\t')
+					n++;
+				open(std::string(rest, n), std::string(n, e));
+				out += "ok\n";
+			} else if (first == "forecast") {
+				forecast(onlinefdr::split_words(std::string(rest, e)), out);
+			} else if (first == "close") {
+				if (!streams.erase(std::string(rest, e)))
+					throw std::invalid_argument("No stream '" + std::string(rest, e) + "'.");
+				out += "ok\n";
+			} else {
+				test(first, std::string(rest, e), out);
+			}
+		} catch (std::exception &err) {
+			out += "error ";
+			out += err.what();
+			out += '\n';
+		}
+	}
+
+	// Answers one binary request on the default stream.
+	void binary(double pval, std::string &out) {
+		double alphai = NAN;
+		unsigned char R = 255;
+		if (pval >= 0 && pval <= 1)
+			R = run(*streams.at("-").proc, pval, alphai);
+		out.append((const char *)&alphai, sizeof alphai);
+		out += (char)R;
+	}
+
+	void tick() {
+		if (!checkpoint.empty() && since >= every)
+			save();
+	}
+
+	// Writes all streams to a temporary file that then replaces the
+	// checkpoint, so a crash leaves the last complete one.
+	void save() {
+		if (checkpoint.empty())
+			throw std::invalid_argument("No checkpoint file was given.");
+		std::string tmp = checkpoint + ".tmp";
+		FILE *f = std::fopen(tmp.c_str(), "w");
+		if (!f)
+			throw std::runtime_error("Cannot write '" + tmp + "'.");
+		std::fprintf(f, "onlinefdr-stream 1\n");
+		for (const auto &it : streams) {
+			std::fprintf(f, "%s\t%s\t", it.first.c_str(), it.second.spec.c_str());
+			std::vector<double> state = it.second.proc->state();
+			for (size_t k = 0; k < state.size(); k++)
+				std::fprintf(f, k ? " %.17g" : "%.17g", state[k]);
+			std::fprintf(f, "\n");
+		}
+		bool ok = std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+		ok = std::fclose(f) == 0 && ok;
+		if (!ok || std::rename(tmp.c_str(), checkpoint.c_str()) != 0)
+			throw std::runtime_error("Cannot write '" + checkpoint + "'.");
+		since = 0;
+	}
+
+	// Reopens the streams saved in the checkpoint, if it exists.
+	void load() {
+		std::ifstream in(checkpoint);
+		if (!in)
+			return;
+		std::string header, line;
+		std::getline(in, header);
+		if (header != "onlinefdr-stream 1")
+			throw std::runtime_error("'" + checkpoint + "' is not a checkpoint.");
+		while (std::getline(in, line)) {
+			size_t t1 = line.find('\t'), t2 = line.find('\t', t1 + 1);
+			if (t1 == std::string::npos || t2 == std::string::npos)
+				throw std::runtime_error("'" + checkpoint + "' is damaged.");
+			std::string name = line.substr(0, t1);
+			open(name, line.substr(t1 + 1, t2 - t1 - 1));
+			std::istringstream values(line.substr(t2 + 1));
+			std::vector<double> state;
+			double x;
+			while (values >> x)
+				state.push_back(x);
+			streams[name].proc->restore(state);
+		}
+	}
+
+private:
+	void test(const std::string &name, const std::string &value, std::string &out) {
+		auto it = streams.find(name);
+		if (it == streams.end())
+			throw std::invalid_argument(name == "-" ? "No default stream." :
+				"No stream '" + name + "'.");
+		char *end;
+		double pval = std::strtod(value.c_str(), &end);
+		if (value.empty() || *end)
+			throw std::invalid_argument("'" + value + "' is not a p-value.");
+		if (!(pval >= 0 && pval <= 1))
+			throw std::invalid_argument("p-values must be between 0 and 1.");
+
+		double alphai;
+		bool R = run(*it->second.proc, pval, alphai);
+		char buf[40];
+		int n = std::snprintf(buf, sizeof buf, "%.17g %d\n", alphai, (int)R);
+		out.append(buf, n);
+	}
+
+	// words are NAME K [J ...]
+	void forecast(const std::vector<std::string> &words, std::string &out) {
+		if (words.size() < 2)
+			throw std::invalid_argument("A forecast needs a stream and a number of tests.");
+		auto it = streams.find(words[0]);
+		if (it == streams.end())
+			throw std::invalid_argument("No stream '" + words[0] + "'.");
+		long k = count(words[1], 1000000);
+		std::vector<double> pval(k, 1.0), alphai(k);
+		for (size_t w = 2; w < words.size(); w++)
+			pval[count(words[w], k) - 1] = 0;
+
+		it->second.proc->plan(k);
+		it->second.proc->forecast(pval.data(), k, alphai.data());
+		for (long t = 0; t < k; t++) {
+			char buf[40];
+			int n = std::snprintf(buf, sizeof buf, t ? " %.17g" : "%.17g", alphai[t]);
+			out.append(buf, n);
+		}
+		out += '\n';
+	}
+
+	// A whole number from 1 to most.
+	static long count(const std::string &word, long most) {
+		char *end;
+		long n = std::strtol(word.c_str(), &end, 10);
+		if (word.empty() || *end || n < 1 || n > most)
+			throw std::invalid_argument("'" + word + "' is not a number of tests from 1 to " +
+				std::to_string(most) + ".");
+		return n;
+	}
+
+	bool run(onlinefdr::Procedure &proc, double pval, double &alphai) {
+		since++;
+		return proc.test(pval, alphai);
+	}
+
+	std::unordered_map<std::string, Stream> streams;
+	std::string checkpoint;
+	long long every, since = 0;
+};
+
+struct Connection {
+	int in, out;
+	std::string buf;
+};
+
+bool write_all(int fd, const std::string &data) {
+	size_t done = 0;
+	while (done < data.size()) {
+		ssize_t n = write(fd, data.data() + done, data.size() - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		done += n;
+	}
+	return true;
+}
+
+// Answers the complete requests in c.buf. Returns false if the replies
+// cannot be delivered.
+bool serve(Server &server, Connection &c, bool binary) {
+	std::string out;
+	size_t used = 0;
+	if (binary) {
+		for (; used + 8 <= c.buf.size(); used += 8) {
+			double pval;
+			std::memcpy(&pval, c.buf.data() + used, 8);
+			server.binary(pval, out);
+		}
+	} else {
+		const char *b = c.buf.data();
+		for (;;) {
+			const char *nl = (const char *)std::memchr(b + used, '\n', c.buf.size() - used);
+			if (!nl)
+				break;
+			server.line(b + used, nl, out);
+			used = nl - b + 1;
+		}
+	}
+	c.buf.erase(0, used);
+	return write_all(c.out, out);
+}
+
+int listen_on(const std::string &path) {
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof addr);
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof addr.sun_path)
+		throw std::runtime_error("The socket path is too long.");
+	std::strcpy(addr.sun_path, path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(path.c_str());
+	if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof addr) < 0 || listen(fd, 64) < 0)
+		throw std::runtime_error("Cannot listen on '" + path + "': " + std::strerror(errno));
+	return fd;
+}
+
+void usage() {
+	std::fprintf(stderr, "usage: onlinefdr-stream [--socket PATH] [--binary] "
+		"[--checkpoint FILE] [--every N] [PROCEDURE [key=value ...]]\n");
+	std::exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	std::string socket_path, checkpoint, spec;
+	bool binary = false;
+	long long every = 100000;
+	for (int k = 1; k < argc; k++) {
+		std::string a = argv[k];
+		if (a == "--socket" && k + 1 < argc) {
+			socket_path = argv[++k];
+		} else if (a == "--checkpoint" && k + 1 < argc) {
+			checkpoint = argv[++k];
+		} else if (a == "--every" && k + 1 < argc) {
+			every = std::atoll(argv[++k]);
+			if (every <= 0)
+				usage();
+		} else if (a == "--binary") {
+			binary = true;
+		} else if (a.compare(0, 2, "--") == 0) {
+			usage();
+		} else {
+			for (; k < argc; k++)
+				spec += (spec.empty() ? "" : " ") + std::string(argv[k]);
+		}
+	}
+
+	Server server(checkpoint, every);
+	int listener = -1;
+	try {
+		if (!checkpoint.empty())
+			server.load();
+		if (!spec.empty()) {
+			if (!server.has("-"))
+				server.open("-", spec);
+			else if (onlinefdr::split_words(server.spec("-")) != onlinefdr::split_words(spec))
+				throw std::runtime_error("The checkpoint has a different default stream.");
+		}
+		if (binary && !server.has("-"))
+			throw std::runtime_error("--binary needs a procedure for the default stream.");
+		if (!socket_path.empty())
+			listener = listen_on(socket_path);
+	} catch (std::exception &e) {
+		std::fprintf(stderr, "onlinefdr-stream: %s\n", e.what());
+		return 1;
+	}
+
+	struct sigaction sa;
+	std::memset(&sa, 0, sizeof sa);
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	std::signal(SIGPIPE, SIG_IGN);
+
+	std::vector<Connection> conns;
+	if (listener < 0)
+		conns.push_back({0, 1, std::string()});
+
+	int status = 0;
+	std::vector<char> chunk(1 << 16);
+	std::vector<pollfd> fds;
+	while (!stopping && (listener >= 0 || !conns.empty())) {
+		fds.clear();
+		if (listener >= 0)
+			fds.push_back({listener, POLLIN, 0});
+		for (const Connection &c : conns)
+			fds.push_back({c.in, POLLIN, 0});
+		if (poll(fds.data(), fds.size(), -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			std::perror("onlinefdr-stream");
+			status = 1;
+			break;
+		}
+
+		size_t first = 0;
+		if (listener >= 0) {
+			first = 1;
+			if (fds[0].revents & POLLIN) {
+				int fd = accept(listener, NULL, NULL);
+				if (fd >= 0)
+					conns.push_back({fd, fd, std::string()});
+			}
+		}
+
+		std::vector<Connection> open;
+		for (size_t k = 0; k < fds.size() - first; k++) {
+			Connection &c = conns[k];
+			bool keep = true;
+			if (fds[first + k].revents) {
+				ssize_t n = read(c.in, chunk.data(), chunk.size());
+				if (n < 0 && errno == EINTR) {
+					// the signal is handled at the top of the loop
+				} else if (n > 0) {
+					c.buf.append(chunk.data(), n);
+					keep = serve(server, c, binary);
+				} else {
+					// a last request without a newline
+					if (!binary && !c.buf.empty()) {
+						c.buf += '\n';
+						serve(server, c, binary);
+					}
+					keep = false;
+				}
+			}
+			if (keep) {
+				open.push_back(std::move(c));
+			} else if (c.in != 0) {
+				close(c.in);
+			}
+		}
+		// connections accepted above were not polled yet
+		for (size_t k = fds.size() - first; k < conns.size(); k++)
+			open.push_back(std::move(conns[k]));
+		conns.swap(open);
+
+		try {
+			server.tick();
+		} catch (std::exception &e) {
+			std::fprintf(stderr, "onlinefdr-stream: %s\n", e.what());
+		}
+	}
+
+	if (listener >= 0) {
+		close(listener);
+		unlink(socket_path.c_str());
+	}
+	if (!checkpoint.empty()) {
+		try {
+			server.save();
+		} catch (std::exception &e) {
+			std::fprintf(stderr, "onlinefdr-stream: %s\n", e.what());
+			status = 1;
+		}
+	}
+	return status;
+}
@@ -0,0 +1,123 @@
+// registry-load: a multithreaded load generator for StreamRegistry. Each
+// of T threads owns S/T streams of a mix of procedures and appends their
+// p-values in chunks of random size, interleaving its streams at random.
+// Every stream is then checked against a serial run of the same p-values,
+// and the throughput and memory per stream are reported. Build it with
+//
+//   c++ -std=c++17 -O2 -pthread -I../include registry-load.cpp -o registry-load
+//
+// Usage: registry-load [THREADS [STREAMS [TESTS]]]
+
+#include <onlineFDR/options.h>
+#include <onlineFDR/registry.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char *specs[] = {"LORD", "SAFFRON", "ADDIS", "LOND", "online_fallback",
+	"LORD version=3", "Alpha_investing", "ADDIS_spending"};
+
+std::string spec_of(int s) {
+	return specs[s % (sizeof specs / sizeof specs[0])];
+}
+
+// p-values of stream s, with about 2% signals
+std::vector<double> pvalues(int s, std::size_t n) {
+	std::mt19937_64 rng(s);
+	std::uniform_real_distribution<double> u(0, 1);
+	std::vector<double> p(n);
+	for (std::size_t i = 0; i < n; i++)
+		p[i] = u(rng) < 0.02 ? u(rng) * 1e-4 : u(rng);
+	return p;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	int T = argc > 1 ? std::atoi(argv[1]) : 8;
+	int S = argc > 2 ? std::atoi(argv[2]) : 10000;
+	std::size_t N = argc > 3 ? std::atoll(argv[3]) : 1000;
+	if (T <= 0 || S <= 0) {
+		std::fprintf(stderr, "usage: registry-load [THREADS [STREAMS [TESTS]]]\n");
+		return 2;
+	}
+
+	onlinefdr::StreamRegistry registry;
+	std::vector<std::string> ids(S);
+	for (int s = 0; s < S; s++) {
+		ids[s] = "experiment-" + std::to_string(s);
+		registry.open(ids[s], onlinefdr::parse_spec(onlinefdr::split_words(spec_of(s))));
+	}
+
+	std::vector<std::vector<double> > alphai(S, std::vector<double>(N));
+	std::vector<std::vector<unsigned char> > R(S, std::vector<unsigned char>(N));
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < T; t++) {
+		threads.emplace_back([&, t]() {
+			std::mt19937 rng(t);
+			std::vector<int> mine;
+			for (int s = t; s < S; s += T)
+				mine.push_back(s);
+			std::vector<std::vector<double> > p(mine.size());
+			std::vector<std::size_t> done(mine.size(), 0);
+			for (std::size_t k = 0; k < mine.size(); k++)
+				p[k] = pvalues(mine[k], N);
+
+			std::vector<std::size_t> active(mine.size());
+			for (std::size_t k = 0; k < mine.size(); k++)
+				active[k] = k;
+			while (!active.empty()) {
+				std::size_t a = rng() % active.size(), k = active[a];
+				std::size_t n = std::min<std::size_t>(N - done[k], 1 + rng() % 64);
+				int s = mine[k];
+				registry.append(ids[s], p[k].data() + done[k], n, alphai[s].data() + done[k],
+					R[s].data() + done[k]);
+				done[k] += n;
+				if (done[k] == N) {
+					active[a] = active.back();
+					active.pop_back();
+				}
+			}
+		});
+	}
+	for (std::thread &th : threads)
+		th.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int mismatches = 0;
+	for (int s = 0; s < S; s++) {
+		std::unique_ptr<onlinefdr::Procedure> proc = onlinefdr::make_procedure(
+			onlinefdr::parse_spec(onlinefdr::split_words(spec_of(s))));
+		std::vector<double> p = pvalues(s, N);
+		for (std::size_t i = 0; i < N; i++) {
+			double a;
+			bool r = proc->test(p[i], a);
+			if (a != alphai[s][i] || r != (bool)R[s][i]) {
+				mismatches++;
+				break;
+			}
+		}
+	}
+
+	std::size_t total = 0, most = 0;
+	for (const onlinefdr::StreamRegistry::Usage &u : registry.usage()) {
+		total += u.bytes;
+		most = std::max(most, u.bytes);
+		if (u.tests != N)
+			mismatches++;
+	}
+
+	std::printf("%d threads, %d streams, %.3g tests/s, %.0f bytes per stream (max %zu), "
+		"%d mismatches\n", T, S, (double)S * N / seconds, (double)total / S, most, mismatches);
+	return mismatches ? 1 : 0;
+}
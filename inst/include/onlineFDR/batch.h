@@ -0,0 +1,378 @@
+#ifndef ONLINEFDR_BATCH_H
+#define ONLINEFDR_BATCH_H
+
+// Batches of BatchBH, BatchStBH and BatchPRDS filled one p-value at a time.
+// An open batch keeps its p-values in an order-statistics tree, so that its
+// provisional numbers of rejections are found in O(log n) after each
+// arrival rather than by sorting the batch again, and the batch is decided
+// from them when it closes.
+//
+// Step-up procedures reject the p-values up to the largest rank r with
+//   p_(r) <= r*c,
+// for a slope c given by the level, the size of the batch and (for St-BH)
+// the null proportion estimate. The tree keeps, for each subtree, the least
+// p_(j) - j*c over its p-values ranked within it, from which the largest
+// such rank is found by one descent. The slope of BH is fixed; that of
+// St-BH changes as the p-values arrive, and the tree is recomputed for it
+// only when a descent has become long.
+//
+// The descent only finds the candidate ranks, up to a rounding tolerance.
+// A rank is rejected as the R implementation rejects it, by
+//   min(1, n/r*pi0*p_(r)) <= alpha,
+// with pi0 = 1 for BH, so that p-values on the line r*c get the same
+// decisions.
+
+#include <cfloat>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "procedures.h"
+
+namespace onlinefdr {
+
+// A treap of p-values ordered by value, with the size and the least
+// p_(j) - j*c of every subtree for two reference slopes c.
+class OrderStats {
+public:
+	explicit OrderStats(std::size_t reserve = 0) {
+		nodes.reserve(reserve);
+	}
+
+	std::size_t size() const {
+		return root < 0 ? 0 : nodes[root].size;
+	}
+
+	// Expected O(log n).
+	void insert(double p) {
+		Node x;
+		x.p = p;
+		x.prio = next_prio();
+		nodes.push_back(x);
+		pull(nodes.size() - 1);
+		index_t a, b;
+		split(root, p, a, b);
+		root = merge(merge(a, nodes.size() - 1), b);
+	}
+
+	// Largest rank r <= most with p_(r) - r*slope <= t, or 0 if there is
+	// none. Expected O(log n) at the reference slope s. At another slope
+	// the least values of the subtrees at the reference only bound those
+	// at the slope, so the descent may visit more of them; past a budget
+	// the slope becomes the reference and the tree is recomputed in O(n).
+	index_t last(int s, double slope, double t, index_t most) {
+		std::size_t visits = 0;
+		index_t r = last(root, 0, s, slope, t, most, visits);
+		std::size_t budget = 64;
+		for (std::size_t n = size(); n; n >>= 1)
+			budget += 8;
+		if (visits > budget) {
+			c[s] = slope;
+			refresh(root);
+		}
+		return r;
+	}
+
+	// Sets the reference slopes, recomputing the tree if they changed.
+	void slopes(double c0, double c1) {
+		if (c0 == c[0] && c1 == c[1])
+			return;
+		c[0] = c0;
+		c[1] = c1;
+		if (root >= 0)
+			refresh(root);
+	}
+
+	// The r-th smallest p-value (r from 1).
+	double at(index_t r) const {
+		index_t x = root;
+		for (;;) {
+			index_t left = count(nodes[x].left);
+			if (r <= left) {
+				x = nodes[x].left;
+			} else if (r == left + 1) {
+				return nodes[x].p;
+			} else {
+				r -= left + 1;
+				x = nodes[x].right;
+			}
+		}
+	}
+
+	void clear() {
+		nodes.clear();
+		root = -1;
+	}
+
+	std::size_t memory() const {
+		return nodes.capacity()*sizeof(Node);
+	}
+
+private:
+	struct Node {
+		double p;
+		double low[2];
+		std::uint32_t prio;
+		index_t left = -1, right = -1, size = 1;
+	};
+
+	std::uint32_t next_prio() {
+		// xorshift32
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed;
+	}
+
+	index_t count(index_t x) const {
+		return x < 0 ? 0 : nodes[x].size;
+	}
+
+	void pull(index_t x) {
+		Node &n = nodes[x];
+		index_t rank = count(n.left) + 1;
+		n.size = rank + count(n.right);
+		for (int s = 0; s < 2; s++) {
+			double low = n.p - rank*c[s];
+			if (n.left >= 0)
+				low = std::min(low, nodes[n.left].low[s]);
+			if (n.right >= 0)
+				low = std::min(low, nodes[n.right].low[s] - rank*c[s]);
+			n.low[s] = low;
+		}
+	}
+
+	void refresh(index_t x) {
+		if (nodes[x].left >= 0)
+			refresh(nodes[x].left);
+		if (nodes[x].right >= 0)
+			refresh(nodes[x].right);
+		pull(x);
+	}
+
+	// Splits x into the p-values below p and the others.
+	void split(index_t x, double p, index_t &a, index_t &b) {
+		if (x < 0) {
+			a = b = -1;
+		} else if (nodes[x].p < p) {
+			split(nodes[x].right, p, nodes[x].right, b);
+			a = x;
+			pull(x);
+		} else {
+			split(nodes[x].left, p, a, nodes[x].left);
+			b = x;
+			pull(x);
+		}
+	}
+
+	index_t merge(index_t a, index_t b) {
+		if (a < 0)
+			return b;
+		if (b < 0)
+			return a;
+		if (nodes[a].prio > nodes[b].prio) {
+			nodes[a].right = merge(nodes[a].right, b);
+			pull(a);
+			return a;
+		}
+		nodes[b].left = merge(a, nodes[b].left);
+		pull(b);
+		return b;
+	}
+
+	// last() within subtree x, whose p-values have ranks from before+1. For
+	// j <= size, p_(j) - (before+j)*slope is at least
+	//   low - before*slope - size*max(slope - c, 0).
+	index_t last(index_t x, index_t before, int s, double slope, double t, index_t most,
+		std::size_t &visits) const {
+		if (x < 0 || before >= most)
+			return 0;
+		const Node &n = nodes[x];
+		double steeper = std::max(slope - c[s], 0.0);
+		if (n.low[s] - before*slope - n.size*steeper > t)
+			return 0;
+		visits++;
+		index_t rank = before + count(n.left) + 1;
+		index_t r = last(n.right, rank, s, slope, t, most, visits);
+		if (r)
+			return r;
+		if (rank <= most && n.p - rank*slope <= t)
+			return rank;
+		return last(n.left, before, s, slope, t, most, visits);
+	}
+
+	std::vector<Node> nodes;
+	index_t root = -1;
+	double c[2] = {0, 0};
+	std::uint32_t seed = 2463534242u;
+};
+
+enum BatchProcedure { BATCH_BH, BATCH_STBH, BATCH_PRDS };
+
+// One batch of n tests at level alpha, open until its n p-values have
+// arrived. The numbers of rejections are those of the batch with the
+// p-values still to come set to 1, so they never exceed the final ones,
+// and are the final ones once the batch is full.
+class OpenBatch {
+public:
+	OpenBatch(BatchProcedure proc, index_t n, double alpha, double lambda = 0.5) :
+		proc(proc), n(n), alpha(alpha), lambda(lambda), tree(n) {
+		update();
+		tree.slopes(slope[0], slope[1]);
+	}
+
+	void add(double p) {
+		tree.insert(p);
+		above += (p > lambda);
+		top = std::max(top, p);
+	}
+
+	index_t arrived() const {
+		return tree.size();
+	}
+
+	bool full() const {
+		return arrived() == n;
+	}
+
+	// Rejections of the step-up procedure. The missing p-values, if any,
+	// take the ranks up to n.
+	index_t rejections() {
+		if (alpha >= 1)
+			return n;
+		update();
+		if (arrived() < n && passes(1, n, pi0[0]))
+			return n;
+		return step_up(0, n, 0);
+	}
+
+	// Largest number of rejections with one p-value set to 0 (R^+ of
+	// BatchBH and BatchStBH). Setting the largest to 0 rejects the most,
+	// as the others then rank no higher and (for St-BH) the null
+	// proportion estimate is no larger. The 0 takes the first rank.
+	index_t rejections_plus() {
+		if (alpha >= 1)
+			return n;
+		update();
+		if (arrived() < n - 1 && passes(1, n, pi0[1]))
+			return n;
+		index_t r = step_up(1, n - 1, 1);
+		return r ? r + 1 : (alpha >= 0 ? 1 : 0);
+	}
+
+	// Whether the batch holds a p-value above lambda (k of BatchStBH).
+	bool above_lambda() const {
+		return full() ? top > lambda : lambda < 1;
+	}
+
+	// The largest p-value rejected, given the number of rejections, or -1
+	// if there is none.
+	double cutoff(index_t rejected) const {
+		if (rejected == 0)
+			return -1;
+		return rejected > arrived() ? 1 : tree.at(rejected);
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this) + tree.memory();
+	}
+
+private:
+	// The slopes of the batch as it is now: p_(r) <= r*alpha/n for BH and
+	// p_(r) <= r*alpha*(1-lambda)/(C+1) for St-BH, where C counts the
+	// p-values above lambda (the missing ones among them if lambda < 1).
+	// R^+ of St-BH has one fewer if the largest is above lambda. The null
+	// proportion estimates are (C+1)/((1-lambda)*n).
+	void update() {
+		if (proc == BATCH_STBH) {
+			index_t C = above + (lambda < 1 ? n - arrived() : 0);
+			index_t Cplus = C - above_lambda();
+			slope[0] = alpha*(1 - lambda)/(C + 1);
+			slope[1] = alpha*(1 - lambda)/(Cplus + 1);
+			pi0[0] = (C + 1)/((1 - lambda)*n);
+			pi0[1] = (Cplus + 1)/((1 - lambda)*n);
+		} else {
+			slope[0] = slope[1] = alpha/n;
+			pi0[0] = pi0[1] = 1;
+		}
+	}
+
+	// Whether p is rejected at rank r, as in the R implementation.
+	bool passes(double p, index_t r, double pi0) const {
+		return std::min(1.0, (double)n/r*pi0*p) <= alpha;
+	}
+
+	// Largest rank r <= most of the tree whose p-value is rejected at rank
+	// r + shift. The tree gives the largest candidate within the tolerance,
+	// which bounds the rounding of the descent; a candidate that is not
+	// rejected is passed over for the next one below it.
+	index_t step_up(int s, index_t most, index_t shift) {
+		double c = slope[s];
+		double tol = 1024*DBL_EPSILON*(1 + n*c);
+		for (;;) {
+			index_t r = tree.last(s, c, shift*c + tol, most);
+			if (r == 0 || passes(tree.at(r), r + shift, pi0[s]))
+				return r;
+			most = r - 1;
+		}
+	}
+
+	BatchProcedure proc;
+	index_t n;
+	double alpha, lambda;
+	OrderStats tree;
+	index_t above = 0;
+	double top = 0;
+	double slope[2] = {0, 0};
+	double pi0[2] = {1, 1};
+};
+
+// The levels of successive batches: after each batch closes with its
+// rejections (and R^+ and k), the level of the next batch of n tests.
+class BatchLevels {
+public:
+	BatchLevels(BatchProcedure proc, const double *gammai, double alpha) : proc(proc),
+		gammai(gammai), alpha(alpha) {}
+
+	double first() const {
+		return gammai[0]*alpha;
+	}
+
+	void close(double level, index_t rejected, index_t plus, bool k) {
+		alphai.push_back(level);
+		R.push_back(rejected);
+		Rplus.push_back(plus);
+		K.push_back(k);
+		Rtotal += rejected;
+	}
+
+	// The level of the next batch, of n tests. Sums are accumulated in long
+	// double, as R's sum() does.
+	double next(index_t n) const {
+		std::size_t i = alphai.size();
+		if (proc == BATCH_PRDS)
+			return alpha*(gammai[i]/n)*(n + Rtotal);
+
+		long double gammasum = 0, spent = 0;
+		for (std::size_t j = 0; j <= i; j++)
+			gammasum += gammai[j];
+		for (std::size_t j = 0; j < i; j++) {
+			double share = Rplus[j]/(Rplus[j] + (double)(Rtotal - R[j]));
+			spent += (proc == BATCH_STBH ? K[j]*alphai[j] : alphai[j])*share;
+		}
+		return ((double)gammasum*alpha - (double)spent)*((n + (double)Rtotal)/n);
+	}
+
+private:
+	BatchProcedure proc;
+	const double *gammai;
+	double alpha;
+	std::vector<double> alphai;
+	std::vector<index_t> R, Rplus;
+	std::vector<bool> K;
+	index_t Rtotal = 0;
+};
+
+} // namespace onlinefdr
+
+#endif
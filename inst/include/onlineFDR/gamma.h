@@ -0,0 +1,194 @@
+#ifndef ONLINEFDR_GAMMA_H
+#define ONLINEFDR_GAMMA_H
+
+// Default gamma sequences. GammaSeq evaluates one term by term for the
+// kernels, so they need no vector of length N; the registry below keeps
+// the first GAMMA_CACHED terms of each family and their partial sums, for
+// the sums of the kernels and the vectors of the R wrappers. A prefix is
+// computed once per session and grown geometrically up to that size;
+// later terms are computed when needed, so the memory held does not grow
+// with N. A table handed out is never modified, so callers on any thread
+// can keep reading it while the registry grows.
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include "gather.h"
+
+namespace onlinefdr {
+
+// Positions in a stream and the counters derived from them. This is the
+// type of R_xlen_t, so long vectors can be indexed on 64-bit platforms.
+typedef std::ptrdiff_t index_t;
+
+enum GammaFamily {
+	GAMMA_POWER,   // 0.4374901658/j^1.6
+	GAMMA_LOG,     // 0.07720838*log(max(j,2))/(j*exp(sqrt(log(j))))
+	GAMMA_LOGCUBE, // 0.139307/(j*log(max(j,2))^3)
+	GAMMA_FAMILIES
+};
+
+// j starts at 1; the operations follow the R expressions they replace
+inline double gamma_term(GammaFamily f, double j) {
+	switch (f) {
+	case GAMMA_POWER:
+		return 0.4374901658/std::pow(j, 1.6);
+	case GAMMA_LOG:
+		return 0.07720838*std::log(std::max(j, 2.0))/(j*std::exp(std::sqrt(std::log(j))));
+	case GAMMA_LOGCUBE:
+		return 0.139307/(j*std::pow(std::log(std::max(j, 2.0)), 3.0));
+	default:
+		return 0;
+	}
+}
+
+// Returns -1 for an unknown name.
+inline int gamma_family(const std::string &name) {
+	if (name == "power")
+		return GAMMA_POWER;
+	if (name == "log")
+		return GAMMA_LOG;
+	if (name == "logcube")
+		return GAMMA_LOGCUBE;
+	return -1;
+}
+
+struct GammaTable {
+	std::vector<double> value;  // gamma_1, ..., gamma_n
+	std::vector<double> cumsum; // gamma_1 + ... + gamma_k
+	long double sum = 0;        // gamma_1 + ... + gamma_n, unrounded
+};
+
+inline std::shared_ptr<const GammaTable> gamma_table(GammaFamily f, size_t n);
+
+// Terms of the closed-form families kept in the registry below; later
+// terms are computed.
+const size_t GAMMA_CACHED = 1 << 20;
+
+// A gamma sequence seen by the kernels: either a table supplied by the user
+// (which must outlive this object) or scale times a closed-form family.
+// Closed-form terms are kept in a small direct-mapped cache, since the
+// kernels read the same few indices for many consecutive tests.
+class GammaSeq {
+public:
+	GammaSeq() {
+		std::fill(key, key + CACHE, (index_t)-1);
+	}
+	GammaSeq(const double *table) : table(table) {}
+	GammaSeq(GammaFamily family, double scale) : family(family), scale(scale) {
+		std::fill(key, key + CACHE, (index_t)-1);
+	}
+
+	double operator[](index_t i) const {
+		if (table)
+			return table[i];
+		int slot = i & (CACHE - 1);
+		if (key[slot] != i) {
+			key[slot] = i;
+			value[slot] = scale*gamma_term(family, i + 1.0);
+		}
+		return value[slot];
+	}
+
+	// Sum of the terms at Q - q[j] for j < n, in the order of gather_sum;
+	// q is non-decreasing. Closed-form terms are read from the registry
+	// (shared by every sequence of the family) up to GAMMA_CACHED, and the
+	// sum is scaled once at the end.
+	double sum(index_t Q, const index_t *q, size_t n) const {
+		double lane[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		lanes(Q, q, n, lane);
+		return scaled(reduce_lanes(lane));
+	}
+
+	// Adds the unscaled terms of sum() to lane, as gather_lanes does.
+	void lanes(index_t Q, const index_t *q, size_t n, double *lane) const {
+		if (table)
+			return gather_lanes(table, std::numeric_limits<index_t>::max(),
+				[this](index_t i) { return table[i]; }, Q, q, n, lane);
+		index_t have = terms ? terms->value.size() : 0;
+		if (Q >= have && have < (index_t)GAMMA_CACHED) {
+			terms = gamma_table(family, std::min<size_t>(Q + 1, GAMMA_CACHED));
+			have = terms->value.size();
+		}
+		GammaFamily f = family;
+		gather_lanes(terms->value.data(), have,
+			[f](index_t i) { return gamma_term(f, i + 1.0); }, Q, q, n, lane);
+	}
+
+	// Term i as lanes() adds it, and the scaling sum() applies to a total
+	// of such terms.
+	double term(index_t i) const {
+		if (table)
+			return table[i];
+		if (terms && i < (index_t)terms->value.size())
+			return terms->value[i];
+		return gamma_term(family, i + 1.0);
+	}
+
+	double scaled(double x) const {
+		return table ? x : scale*x;
+	}
+
+private:
+	static const int CACHE = 64;
+	const double *table = nullptr;
+	GammaFamily family = GAMMA_POWER;
+	double scale = 1;
+	mutable index_t key[CACHE] = {};
+	mutable double value[CACHE] = {};
+	mutable std::shared_ptr<const GammaTable> terms;
+};
+
+// A table holding the first min(n, GAMMA_CACHED) terms of family f, or
+// more.
+inline std::shared_ptr<const GammaTable> gamma_table(GammaFamily f, size_t n) {
+	static std::mutex lock;
+	static std::shared_ptr<const GammaTable> tables[GAMMA_FAMILIES];
+
+	std::lock_guard<std::mutex> guard(lock);
+	std::shared_ptr<const GammaTable> &t = tables[f];
+	size_t have = t ? t->value.size() : 0;
+	n = std::min(n, GAMMA_CACHED);
+	if (have >= n)
+		return t;
+
+	size_t size = std::min(std::max(n, std::max(have*2, (size_t)1024)), GAMMA_CACHED);
+	std::shared_ptr<GammaTable> grown(new GammaTable);
+	grown->value.reserve(size);
+	grown->cumsum.reserve(size);
+	if (t) {
+		grown->value = t->value;
+		grown->cumsum = t->cumsum;
+	}
+	// accumulated in long double, as sum() does in R
+	long double sum = have ? t->sum : 0;
+	for (size_t j = have; j < size; j++) {
+		double g = gamma_term(f, j+1);
+		sum += g;
+		grown->value.push_back(g);
+		grown->cumsum.push_back(sum);
+	}
+	grown->sum = sum;
+	t = grown;
+	return t;
+}
+
+// gamma_1 + ... + gamma_n, without keeping more than the registry holds.
+inline double gamma_total(GammaFamily f, size_t n) {
+	if (n <= GAMMA_CACHED)
+		return n ? gamma_table(f, n)->cumsum[n-1] : 0;
+	std::shared_ptr<const GammaTable> t = gamma_table(f, GAMMA_CACHED);
+	long double sum = t->sum;
+	for (size_t j = GAMMA_CACHED; j < n; j++)
+		sum += gamma_term(f, j+1);
+	return sum;
+}
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef ONLINEFDR_GATHER_H
+#define ONLINEFDR_GATHER_H
+
+// Sums of a sequence at indices Q - q_j, the inner loop of the levels of
+// the generalised alpha-investing procedures (one term per past rejection).
+// The terms are gathered with AVX-512 or AVX2 where the CPU has them, and
+// with a portable loop elsewhere. The order of the additions is fixed and
+// the same on every path, so the sums are reproducible bit for bit across
+// machines: term j is added to lane j % 8, and the eight lanes are combined
+// as an 8-wide register is reduced,
+//   ((l0 + l4) + (l2 + l6)) + ((l1 + l5) + (l3 + l7)).
+//
+// Indices are 64-bit, so streams longer than 2^31 tests keep working; the
+// 64-bit gathers take as many doubles per instruction as the 32-bit ones.
+// Dispatch is off on Windows, where GCC does not align the stack for AVX
+// spills.
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) \
+	&& !defined(_WIN32)
+#define ONLINEFDR_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace onlinefdr {
+
+enum SimdLevel { SIMD_PORTABLE, SIMD_AVX2, SIMD_AVX512, SIMD_LEVELS };
+
+// The best level this CPU supports.
+inline int simd_supported() {
+#ifdef ONLINEFDR_SIMD_X86
+	static const int level = __builtin_cpu_supports("avx512f") ? SIMD_AVX512 :
+		__builtin_cpu_supports("avx2") ? SIMD_AVX2 : SIMD_PORTABLE;
+	return level;
+#else
+	return SIMD_PORTABLE;
+#endif
+}
+
+inline std::atomic<int> &simd_setting() {
+	static std::atomic<int> level(simd_supported());
+	return level;
+}
+
+// The level in use, the best supported unless lowered by set_simd_level.
+inline int simd_level() {
+	return simd_setting().load(std::memory_order_relaxed);
+}
+
+// Uses at most level l, as far as the CPU supports it. Returns the level
+// now in use.
+inline int set_simd_level(int l) {
+	int level = std::max(0, std::min(l, simd_supported()));
+	simd_setting().store(level, std::memory_order_relaxed);
+	return level;
+}
+
+namespace detail {
+
+// Adds t[Q - q[j]] to lane j % 8 for the n blocks of 8 terms from q.
+inline void gather_blocks_portable(const double *t, std::ptrdiff_t Q, const std::ptrdiff_t *q,
+	std::size_t n, double *lane) {
+	for (std::size_t b = 0; b < n; b++, q += 8)
+		for (int k = 0; k < 8; k++)
+			lane[k] += t[Q - q[k]];
+}
+
+#ifdef ONLINEFDR_SIMD_X86
+__attribute__((target("avx2")))
+inline void gather_blocks_avx2(const double *t, std::ptrdiff_t Q, const std::ptrdiff_t *q,
+	std::size_t n, double *lane) {
+	__m256d lo = _mm256_loadu_pd(lane), hi = _mm256_loadu_pd(lane + 4);
+	__m256i base = _mm256_set1_epi64x(Q);
+	for (std::size_t b = 0; b < n; b++, q += 8) {
+		__m256i i0 = _mm256_sub_epi64(base, _mm256_loadu_si256((const __m256i *)q));
+		__m256i i1 = _mm256_sub_epi64(base, _mm256_loadu_si256((const __m256i *)(q + 4)));
+		lo = _mm256_add_pd(lo, _mm256_i64gather_pd(t, i0, 8));
+		hi = _mm256_add_pd(hi, _mm256_i64gather_pd(t, i1, 8));
+	}
+	_mm256_storeu_pd(lane, lo);
+	_mm256_storeu_pd(lane + 4, hi);
+}
+
+__attribute__((target("avx512f")))
+inline void gather_blocks_avx512(const double *t, std::ptrdiff_t Q, const std::ptrdiff_t *q,
+	std::size_t n, double *lane) {
+	__m512d acc = _mm512_loadu_pd(lane);
+	__m512i base = _mm512_set1_epi64(Q);
+	for (std::size_t b = 0; b < n; b++, q += 8) {
+		__m512i i = _mm512_sub_epi64(base, _mm512_loadu_si512((const void *)q));
+		// the masked form, since the plain one warns of an undefined source
+		acc = _mm512_add_pd(acc, _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, i, t, 8));
+	}
+	_mm512_storeu_pd(lane, acc);
+}
+#endif
+
+inline void gather_blocks(const double *t, std::ptrdiff_t Q, const std::ptrdiff_t *q,
+	std::size_t n, double *lane) {
+	if (n == 0)
+		return;
+#ifdef ONLINEFDR_SIMD_X86
+	switch (simd_level()) {
+	case SIMD_AVX512:
+		return gather_blocks_avx512(t, Q, q, n, lane);
+	case SIMD_AVX2:
+		return gather_blocks_avx2(t, Q, q, n, lane);
+	}
+#endif
+	gather_blocks_portable(t, Q, q, n, lane);
+}
+
+} // namespace detail
+
+// Adds the terms at Q - q[j] for j < n to lane[j % 8], in the order above.
+// Indices below size are read from t, and the others computed by
+// term(index). q must be non-decreasing (it holds the times of past
+// rejections), so the computed terms come first.
+template <class Term>
+void gather_lanes(const double *t, std::ptrdiff_t size, Term term, std::ptrdiff_t Q,
+	const std::ptrdiff_t *q, std::size_t n, double *lane) {
+	// q[j] > Q - size once the index is in the table
+	std::size_t j = std::upper_bound(q, q + n, Q - size) - q;
+	for (std::size_t k = 0; k < j; k++)
+		lane[k & 7] += term(Q - q[k]);
+
+	std::size_t aligned = std::min(n, (j + 7) & ~(std::size_t)7);
+	for (; j < aligned; j++)
+		lane[j & 7] += t[Q - q[j]];
+
+	std::size_t blocks = (n - j) / 8;
+	detail::gather_blocks(t, Q, q + j, blocks, lane);
+	for (j += 8*blocks; j < n; j++)
+		lane[j & 7] += t[Q - q[j]];
+}
+
+inline double reduce_lanes(const double *lane) {
+	return ((lane[0] + lane[4]) + (lane[2] + lane[6])) +
+		((lane[1] + lane[5]) + (lane[3] + lane[7]));
+}
+
+// Sum over j < n of the terms at Q - q[j], as gather_lanes adds them.
+template <class Term>
+double gather_sum(const double *t, std::ptrdiff_t size, Term term, std::ptrdiff_t Q,
+	const std::ptrdiff_t *q, std::size_t n) {
+	double lane[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+	gather_lanes(t, size, term, Q, q, n, lane);
+	return reduce_lanes(lane);
+}
+
+// The same for a table that holds every index.
+inline double gather_sum(const double *t, std::ptrdiff_t Q, const std::ptrdiff_t *q,
+	std::size_t n) {
+	return gather_sum(t, std::numeric_limits<std::ptrdiff_t>::max(),
+		[t](std::ptrdiff_t i) { return t[i]; }, Q, q, n);
+}
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef ONLINEFDR_MAPPED_H
+#define ONLINEFDR_MAPPED_H
+
+// Memory-mapped flat binary files, so that streams larger than memory are
+// read and written through the page cache. Processed ranges are released
+// with release(), which keeps the resident memory bounded by the window
+// the caller works on.
+
+#include <string>
+#include <cstddef>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace onlinefdr {
+
+class MappedFile {
+public:
+	// Maps path read-only if size < 0; otherwise creates (or truncates) it
+	// with the given size in bytes and maps it for writing.
+	MappedFile(const std::string &path, long long size = -1) : writable(size >= 0) {
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+			FILE_SHARE_READ, NULL, writable ? CREATE_ALWAYS : OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("Cannot open '" + path + "'.");
+		LARGE_INTEGER n;
+		if (writable) {
+			n.QuadPart = size;
+			if (!SetFilePointerEx(file, n, NULL, FILE_BEGIN) || !SetEndOfFile(file)) {
+				CloseHandle(file);
+				throw std::runtime_error("Cannot resize '" + path + "'.");
+			}
+		} else {
+			GetFileSizeEx(file, &n);
+		}
+		len = n.QuadPart;
+		if (len > 0) {
+			map = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+				0, 0, NULL);
+			if (map != NULL)
+				data = (char *)MapViewOfFile(map, writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+					0, 0, 0);
+			if (data == NULL) {
+				close();
+				throw std::runtime_error("Cannot map '" + path + "'.");
+			}
+		}
+#else
+		fd = writable ? ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644)
+			: ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("Cannot open '" + path + "'.");
+		if (writable) {
+			if (::ftruncate(fd, size) != 0) {
+				close();
+				throw std::runtime_error("Cannot resize '" + path + "'.");
+			}
+			len = size;
+		} else {
+			struct stat st;
+			::fstat(fd, &st);
+			len = st.st_size;
+		}
+		if (len > 0) {
+			void *p = ::mmap(NULL, len, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+				MAP_SHARED, fd, 0);
+			if (p == MAP_FAILED) {
+				close();
+				throw std::runtime_error("Cannot map '" + path + "'.");
+			}
+			data = (char *)p;
+			::madvise(data, len, MADV_SEQUENTIAL);
+		}
+#endif
+	}
+
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	char *begin() const { return data; }
+	long long size() const { return len; }
+
+	// Writes back and drops the pages of [from, to), which the caller has
+	// finished with. Pages are only hints to the OS, so errors are ignored.
+	void release(long long from, long long to) {
+#ifndef _WIN32
+		long long page = ::sysconf(_SC_PAGESIZE);
+		from -= from % page;
+		to -= to % page;
+		if (data == NULL || to <= from)
+			return;
+		if (writable)
+			::msync(data + from, to - from, MS_ASYNC);
+		::madvise(data + from, to - from, MADV_DONTNEED);
+#else
+		(void)from;
+		(void)to;
+#endif
+	}
+
+private:
+	void close() {
+#ifdef _WIN32
+		if (data != NULL)
+			UnmapViewOfFile(data);
+		if (map != NULL)
+			CloseHandle(map);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		map = NULL;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data != NULL)
+			::munmap(data, len);
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+#endif
+		data = NULL;
+	}
+
+	bool writable;
+	char *data = NULL;
+	long long len = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE map = NULL;
+#else
+	int fd = -1;
+#endif
+};
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef ONLINEFDR_ONLINEFDR_H
+#define ONLINEFDR_ONLINEFDR_H
+
+// Header-only C++17 core of the onlineFDR procedures, with no dependency on
+// R. Packages can use it with LinkingTo: onlineFDR, and other programs by
+// adding inst/include to the include path. For example
+//
+//   onlinefdr::ProcedureSpec s;
+//   s.procedure = "SAFFRON";
+//   s.gammai = onlinefdr::GammaSeq(onlinefdr::GAMMA_POWER, 1);
+//   onlinefdr::Saffron proc(s);
+//   onlinefdr::run(proc, pval, n, alphai, R);
+//
+// runs SAFFRON with its default parameters over n p-values.
+
+#include "gamma.h"
+#include "procedures.h"
+#include "stream.h"
+#include "stats.h"
+#include "sink.h"
+#include "batch.h"
+#include "radix.h"
+#include "mapped.h"
+#include "options.h"
+#include "registry.h"
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef ONLINEFDR_OPTIONS_H
+#define ONLINEFDR_OPTIONS_H
+
+// Procedure specifications written as words, for programs outside R:
+//
+//   SAFFRON alpha=0.05 lambda=0.5 gamma=power
+//
+// The first word is the procedure and the others are key=value pairs named
+// as the arguments of procedureSpec() in R (alpha, version, w0, b0, lambda,
+// tau, original) plus gamma, the family of the default sequence. Missing
+// values get the defaults of procedureSpec().
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+#include "gamma.h"
+#include "procedures.h"
+
+namespace onlinefdr {
+
+// Splits a line into words separated by blanks.
+inline std::vector<std::string> split_words(const std::string &line) {
+	std::vector<std::string> words;
+	std::istringstream in(line);
+	std::string w;
+	while (in >> w)
+		words.push_back(w);
+	return words;
+}
+
+// Throws std::invalid_argument with the message procedureSpec() gives.
+inline ProcedureSpec parse_spec(const std::vector<std::string> &words) {
+	if (words.empty())
+		throw std::invalid_argument("No procedure given.");
+
+	ProcedureSpec s;
+	s.procedure = words[0];
+	static const char *known[] = {"LORD", "LOND", "SAFFRON", "ADDIS", "Alpha_investing",
+		"ADDIS_spending", "Alpha_spending", "online_fallback"};
+	bool found = false;
+	for (const char *k : known)
+		found = found || s.procedure == k;
+	if (!found)
+		throw std::invalid_argument("procedure must be one of LORD, LOND, SAFFRON, ADDIS, "
+			"Alpha_investing, ADDIS_spending, Alpha_spending or online_fallback.");
+
+	std::string version = "++", gamma;
+	bool has_w0 = false, has_b0 = false, has_lambda = false;
+	for (size_t k = 1; k < words.size(); k++) {
+		size_t eq = words[k].find('=');
+		if (eq == std::string::npos)
+			throw std::invalid_argument("Expected key=value, not '" + words[k] + "'.");
+		std::string key = words[k].substr(0, eq), value = words[k].substr(eq + 1);
+
+		if (key == "version") {
+			version = value;
+			continue;
+		} else if (key == "gamma") {
+			gamma = value;
+			continue;
+		} else if (key == "original") {
+			if (value != "TRUE" && value != "FALSE")
+				throw std::invalid_argument("original must be TRUE or FALSE.");
+			s.original = value == "TRUE";
+			continue;
+		}
+
+		char *end;
+		double x = std::strtod(value.c_str(), &end);
+		if (value.empty() || *end)
+			throw std::invalid_argument(key + " must be a number.");
+		if (key == "alpha") {
+			s.alpha = x;
+		} else if (key == "w0") {
+			s.w0 = x;
+			has_w0 = true;
+		} else if (key == "b0") {
+			s.b0 = x;
+			has_b0 = true;
+		} else if (key == "lambda") {
+			s.lambda = x;
+			has_lambda = true;
+		} else if (key == "tau") {
+			s.tau = x;
+		} else {
+			throw std::invalid_argument("Unknown option '" + key + "'.");
+		}
+	}
+
+	if (!(s.alpha > 0 && s.alpha <= 1))
+		throw std::invalid_argument("alpha must be between 0 and 1.");
+
+	s.version = 1;
+	if (s.procedure == "LORD") {
+		if (version == "++")
+			s.version = 1;
+		else if (version == "discard")
+			s.version = 2;
+		else if (version == "3")
+			s.version = 3;
+		else if (version == "dep")
+			s.version = 4;
+		else
+			throw std::invalid_argument("version must be '++', 3, 'discard' or 'dep'.");
+	}
+
+	if (!has_w0)
+		s.w0 = s.procedure == "LORD" ? s.alpha/10 : s.alpha/2;
+	else if (s.w0 < 0)
+		throw std::invalid_argument("w0 must be non-negative.");
+	else if (s.w0 > s.alpha)
+		throw std::invalid_argument("w0 must not be greater than alpha.");
+
+	if (!has_b0)
+		s.b0 = s.alpha - s.w0;
+	else if (!(s.b0 > 0))
+		throw std::invalid_argument("b0 must be positive.");
+
+	if (!has_lambda)
+		s.lambda = s.procedure == "SAFFRON" ? 0.5 : 0.25;
+	else if (!(s.lambda > 0 && s.lambda <= 1))
+		throw std::invalid_argument("lambda must be between 0 and 1.");
+
+	if (!(s.tau > 0 && s.tau <= 1))
+		throw std::invalid_argument("tau must be between 0 and 1.");
+
+	// the candidates of ADDIS must be selected
+	if (s.procedure == "ADDIS" && s.lambda > s.tau)
+		throw std::invalid_argument("lambda must be between 0 and tau.");
+	if (s.procedure == "ADDIS_spending" && s.lambda >= s.tau)
+		throw std::invalid_argument("lambda must be less than tau.");
+
+	// the defaults of defaultGammai()
+	std::string family = "power";
+	double scale = 1;
+	if (s.procedure == "LORD") {
+		family = s.version == 4 ? "logcube" : "log";
+	} else if (s.procedure == "LOND") {
+		family = "log";
+		scale = s.alpha;
+	} else if (s.procedure == "Alpha_spending" || s.procedure == "online_fallback") {
+		family = "log";
+	}
+	if (!gamma.empty())
+		family = gamma;
+
+	int f = gamma_family(family);
+	if (f < 0)
+		throw std::invalid_argument("Unknown gamma sequence '" + family + "'.");
+	// an unbounded stream has no length to normalise the sequence over
+	if (s.version == 4 && s.w0 > s.b0 && gamma.empty())
+		throw std::invalid_argument("LORD with version 'dep' needs w0 <= b0 on an open stream.");
+	s.gammai = GammaSeq((GammaFamily)f, scale);
+	return s;
+}
+
+} // namespace onlinefdr
+
+#endif
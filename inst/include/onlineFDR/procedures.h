@@ -0,0 +1,595 @@
+#ifndef ONLINEFDR_PROCEDURES_H
+#define ONLINEFDR_PROCEDURES_H
+
+// Sequential (synchronous) online testing procedures written against plain
+// arrays, so they can be stepped from worker threads without touching R.
+// Each procedure holds the history it needs: level() gives the threshold
+// alpha_i for the next hypothesis and update() records its p-value.
+// state() and restore() save and reload that history, so a stream can be
+// resumed later by a procedure built from the same specification, and
+// forecast() gives the levels of the next tests under assumed outcomes.
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "gamma.h"
+
+namespace onlinefdr {
+
+// Parameters of one procedure. gammai (or betai for LOND) is a closed-form
+// sequence, or a table that must outlive the procedures created from it and
+// have the length the R wrappers provide.
+struct ProcedureSpec {
+	std::string procedure;
+	int version = 1;
+	GammaSeq gammai;
+	double alpha = 0.05;
+	double w0 = 0.005;
+	double b0 = 0.045;
+	double lambda = 0.5;
+	double tau = 0.5;
+	bool original = true;
+};
+
+class Procedure {
+public:
+	virtual ~Procedure() {}
+	virtual double level() const = 0;
+
+	// Records the outcome of the current test. cand and selected are the
+	// indicators pval <= candidate() and pval <= selection(), which callers
+	// running several procedures can compute once and share.
+	virtual void observe(double alphai, bool rejected, bool cand, bool selected) = 0;
+	virtual double candidate() const { return 1; }
+	virtual double selection() const { return 1; }
+
+	void update(double pval, double alphai) {
+		observe(alphai, pval <= alphai, pval <= candidate(), pval <= selection());
+	}
+
+	bool test(double pval, double &alphai) {
+		alphai = level();
+		update(pval, alphai);
+		return pval <= alphai;
+	}
+
+	// The history as a flat list of numbers. Counters are stored exactly
+	// as doubles up to 2^53.
+	virtual std::vector<double> state() const = 0;
+	virtual void restore(const std::vector<double> &state) = 0;
+
+	// Bytes held by the procedure, including its history.
+	virtual std::size_t memory() const = 0;
+
+	// Number of past rejections that level() sums over, so its cost.
+	virtual std::size_t history() const { return 0; }
+
+	// Levels the next k tests would get if their p-values were pval,
+	// leaving the procedure unchanged: 1 stands for a test assumed null and
+	// 0 for a rejection. Costs O(k) levels.
+	virtual void forecast(const double *pval, std::size_t k, double *alphai) const = 0;
+
+	// Keeps the sums needed by forecasts of up to k tests up to date as the
+	// tests run, so that level() and those forecasts take time independent
+	// of the number of past rejections. This costs O(k) per rejection and
+	// O(k) memory; procedures whose levels need no sum ignore it.
+	virtual void plan(std::size_t) {}
+
+protected:
+	static void check_state(const std::vector<double> &state, size_t size) {
+		if (state.size() != size)
+			throw std::invalid_argument("The saved state does not match the procedure.");
+	}
+};
+
+// forecast() of a procedure whose state does not grow: a copy is stepped.
+template <class Proc>
+void forecast_copy(const Proc &proc, const double *pval, std::size_t k, double *alphai) {
+	Proc copy(proc);
+	for (std::size_t t = 0; t < k; t++) {
+		alphai[t] = copy.level();
+		copy.update(pval[t], alphai[t]);
+	}
+}
+
+// LORD 3 (dep = false) and LORD under dependence (dep = true)
+class LordWealth final : public Procedure {
+public:
+	LordWealth(const ProcedureSpec &s, bool dep) : g(s.gammai), w0(s.w0), b0(s.b0), dep(dep),
+		W(s.w0), Wtau(s.w0) {}
+
+	double level() const {
+		if (i == 0)
+			return g[0]*w0;
+		index_t taumax = Rcur ? i : tau;
+		double Wtaumax = Rcur ? W : Wtau;
+		return dep ? g[i]*Wtaumax : g[ i-taumax ]*Wtaumax;
+	}
+
+	void observe(double alphai, bool rejected, bool, bool) {
+		int Rnew = rejected;
+		if (i > 0 && Rcur) {
+			tau = i;
+			Wtau = W;
+		}
+		// LORD 3 pays out for the rejection before last, except at the start
+		int payout = (dep || i == 0) ? Rnew : Rprev;
+		W = W - alphai + payout*b0;
+		Rprev = (i == 0) ? 1 : Rcur;
+		Rcur = Rnew;
+		i++;
+	}
+
+	std::vector<double> state() const {
+		return {W, Wtau, (double)i, (double)tau, (double)Rprev, (double)Rcur};
+	}
+
+	void restore(const std::vector<double> &state) {
+		check_state(state, 6);
+		W = state[0];
+		Wtau = state[1];
+		i = state[2];
+		tau = state[3];
+		Rprev = state[4];
+		Rcur = state[5];
+	}
+
+	void forecast(const double *pval, std::size_t k, double *alphai) const {
+		forecast_copy(*this, pval, k, alphai);
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this);
+	}
+
+private:
+	GammaSeq g;
+	double w0, b0;
+	bool dep;
+	double W, Wtau;
+	index_t i = 0;
+	index_t tau = 0;
+	int Rprev = 1;
+	int Rcur = 0;
+};
+
+class Lond final : public Procedure {
+public:
+	explicit Lond(const ProcedureSpec &s) : betai(s.gammai), original(s.original) {}
+
+	double level() const {
+		return original ? betai[i]*(D+1) : betai[i]*std::max<index_t>(D, 1);
+	}
+
+	void observe(double, bool rejected, bool, bool) {
+		if (rejected)
+			D++;
+		i++;
+	}
+
+	std::vector<double> state() const {
+		return {(double)i, (double)D};
+	}
+
+	void restore(const std::vector<double> &state) {
+		check_state(state, 2);
+		i = state[0];
+		D = state[1];
+	}
+
+	void forecast(const double *pval, std::size_t k, double *alphai) const {
+		forecast_copy(*this, pval, k, alphai);
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this);
+	}
+
+private:
+	GammaSeq betai;
+	bool original;
+	index_t i = 0;
+	index_t D = 0;
+};
+
+// Generalised alpha-investing engine shared by LORD++, LORD with
+// discarding, SAFFRON, ADDIS and Alpha-investing. Q is a counter of the
+// tests that keep earning wealth and q holds its value at each rejection,
+// so the level is
+//   transform(w0*g[Q] + (alpha-w0)*g[Q-q_1] + alpha*sum_{j>1} g[Q-q_j]).
+// The Rule policy gives the candidate and selection thresholds, the
+// increment of Q after a test, the reward per rejection and the transform
+// of the sum, and is resolved at compile time. The sum over j > 1 is
+// gathered in a fixed order by GammaSeq::sum.
+//
+// Once planned for k tests, the engine also keeps the lanes of that sum at
+// Q, ..., Q+k-1 in a ring, indexed by the counter value modulo k. A
+// rejection adds its term to every slot and each step of Q fills the slot
+// that falls out of the ring, so level() and forecasts read the sums
+// instead of gathering them. The terms enter each lane in the order
+// gather_lanes adds them, so the levels are the same bits either way.
+template <class Rule>
+class Gai final : public Procedure {
+public:
+	explicit Gai(const ProcedureSpec &s) : rule(s), g(s.gammai), alpha(rule.reward(s.alpha)),
+		w0(s.w0) {}
+
+	double level() const {
+		double lane[8];
+		lanes(Q, lane);
+		return level_at(Q, i, q.size() ? q.data() : nullptr, lane);
+	}
+
+	double candidate() const { return rule.candidate(); }
+	double selection() const { return rule.selection(); }
+
+	void observe(double, bool rejected, bool cand, bool selected) {
+		int step = rule.step(rejected, cand, selected);
+		Q += step;
+		if (horizon && step == 1) {
+			// the slot of Q-1 becomes that of Q+horizon-1
+			double *lane = slot(Q + horizon - 1);
+			std::fill(lane, lane + 8, 0.0);
+			sum_lanes(Q + horizon - 1, lane);
+		} else if (horizon && step) {
+			fill_window();
+		}
+		if (rejected) {
+			q.push_back(Q);
+			if (horizon && q.size() > 1)
+				for (index_t d = 0; d < (index_t)horizon; d++)
+					slot(Q + d)[(q.size() - 2) & 7] += g.term(d);
+		}
+		i++;
+	}
+
+	void forecast(const double *pval, std::size_t k, double *alphai) const {
+		index_t P = Q;
+		// the assumed rejections, and the number of past ones in the sum
+		std::vector<index_t> more;
+		std::size_t before = q.size() ? q.size() - 1 : 0;
+		for (std::size_t t = 0; t < k; t++) {
+			double lane[8];
+			lanes(P, lane);
+			const index_t *first = q.size() ? q.data() : more.size() ? more.data() : nullptr;
+			for (std::size_t m = q.size() ? 0 : 1; m < more.size(); m++)
+				lane[(before + m - (q.size() ? 0 : 1)) & 7] += g.term(P - more[m]);
+			alphai[t] = level_at(P, i + t, first, lane);
+
+			bool rejected = pval[t] <= alphai[t];
+			P += rule.step(rejected, pval[t] <= candidate(), pval[t] <= selection());
+			if (rejected)
+				more.push_back(P);
+		}
+	}
+
+	void plan(std::size_t k) {
+		if (k > horizon) {
+			horizon = k;
+			fill_window();
+		}
+	}
+
+	// i, Q and then q
+	std::vector<double> state() const {
+		std::vector<double> out = {(double)i, (double)Q};
+		out.insert(out.end(), q.begin(), q.end());
+		return out;
+	}
+
+	void restore(const std::vector<double> &state) {
+		if (state.size() < 2)
+			check_state(state, 2);
+		i = state[0];
+		Q = state[1];
+		q.assign(state.begin() + 2, state.end());
+		if (horizon)
+			fill_window();
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this) + q.capacity()*sizeof(index_t) +
+			window.capacity()*sizeof(double);
+	}
+
+	std::size_t history() const {
+		return q.size();
+	}
+
+private:
+	// The level of test n at counter value P, given the first rejection
+	// (if any) and the lanes of the sum over the later ones.
+	double level_at(index_t P, index_t n, const index_t *first, const double *lane) const {
+		double alphaitilde = w0*g[P];
+		if (first) {
+			double Cjsum = g.scaled(reduce_lanes(lane));
+			alphaitilde += (alpha-w0)*g[ P-*first ] + alpha*Cjsum;
+		}
+		return rule.transform(alphaitilde, n);
+	}
+
+	// Lanes of the sum over the past rejections j > 1 at counter value P.
+	void lanes(index_t P, double *lane) const {
+		if (P >= Q && P - Q < (index_t)horizon) {
+			const double *w = &window[8*ring(P)];
+			std::copy(w, w + 8, lane);
+		} else {
+			std::fill(lane, lane + 8, 0.0);
+			sum_lanes(P, lane);
+		}
+	}
+
+	void sum_lanes(index_t P, double *lane) const {
+		if (q.size() > 1)
+			g.lanes(P, q.data() + 1, q.size() - 1, lane);
+	}
+
+	std::size_t ring(index_t P) const {
+		index_t h = horizon;
+		return ((P % h) + h) % h;
+	}
+
+	double *slot(index_t P) {
+		return &window[8*ring(P)];
+	}
+
+	void fill_window() {
+		window.assign(8*horizon, 0.0);
+		for (index_t d = 0; d < (index_t)horizon; d++)
+			sum_lanes(Q + d, slot(Q + d));
+	}
+
+	Rule rule;
+	GammaSeq g;
+	double alpha, w0;
+	index_t i = 0;
+	index_t Q = 0;
+	std::vector<index_t> q;
+	std::size_t horizon = 0;
+	std::vector<double> window;
+};
+
+// LORD++: Q counts every test.
+struct LordPlusRule {
+	explicit LordPlusRule(const ProcedureSpec &) {}
+	double candidate() const { return 1; }
+	double selection() const { return 1; }
+	double reward(double alpha) const { return alpha; }
+	int step(bool, bool, bool) const { return 1; }
+	double transform(double x, index_t) const { return x; }
+};
+
+// LORD with discarding: Q counts the selected tests. The first level is
+// not capped at tau.
+struct LordDiscardRule {
+	explicit LordDiscardRule(const ProcedureSpec &s) : tau(s.tau) {}
+	double candidate() const { return 1; }
+	double selection() const { return tau; }
+	double reward(double alpha) const { return tau*alpha; }
+	int step(bool, bool, bool selected) const { return selected; }
+	double transform(double x, index_t i) const { return i == 0 ? x : std::min(tau, x); }
+	double tau;
+};
+
+// SAFFRON: Q counts the non-candidates.
+struct SaffronRule {
+	explicit SaffronRule(const ProcedureSpec &s) : lambda(s.lambda) {}
+	double candidate() const { return lambda; }
+	double selection() const { return 1; }
+	double reward(double alpha) const { return alpha; }
+	int step(bool, bool cand, bool) const { return !cand; }
+	double transform(double x, index_t) const { return std::min(lambda, (1-lambda)*x); }
+	double lambda;
+};
+
+// ADDIS: Q counts the selected non-candidates. A candidate that is not
+// selected would make it negative, so lambda may not exceed tau.
+struct AddisRule {
+	explicit AddisRule(const ProcedureSpec &s) : lambda(s.lambda), tau(s.tau) {
+		if (!(lambda <= tau))
+			throw std::invalid_argument("lambda must be between 0 and tau.");
+	}
+	double candidate() const { return lambda; }
+	double selection() const { return tau; }
+	double reward(double alpha) const { return alpha; }
+	int step(bool, bool cand, bool selected) const { return selected - cand; }
+	double transform(double x, index_t) const { return std::min(lambda, (tau-lambda)*x); }
+	double lambda, tau;
+};
+
+// Alpha-investing: Q counts the non-rejections.
+struct AlphaInvestingRule {
+	explicit AlphaInvestingRule(const ProcedureSpec &) {}
+	double candidate() const { return 1; }
+	double selection() const { return 1; }
+	double reward(double alpha) const { return alpha; }
+	int step(bool rejected, bool, bool) const { return !rejected; }
+	double transform(double x, index_t) const { return x/(1+x); }
+};
+
+typedef Gai<LordPlusRule> LordPlus;
+typedef Gai<LordDiscardRule> LordDiscard;
+typedef Gai<SaffronRule> Saffron;
+typedef Gai<AddisRule> Addis;
+typedef Gai<AlphaInvestingRule> AlphaInvesting;
+
+class AddisSpending final : public Procedure {
+public:
+	explicit AddisSpending(const ProcedureSpec &s) : g(s.gammai), alpha(s.alpha),
+		lambda(s.lambda), tau(s.tau) {
+		if (!(lambda < tau))
+			throw std::invalid_argument("lambda must be less than tau.");
+	}
+
+	double level() const {
+		return alpha * (tau - lambda) * g[Q];
+	}
+
+	double candidate() const { return lambda; }
+	double selection() const { return tau; }
+
+	void observe(double, bool, bool cand, bool selected) {
+		Q += selected - cand;
+	}
+
+	std::vector<double> state() const {
+		return {(double)Q};
+	}
+
+	void restore(const std::vector<double> &state) {
+		check_state(state, 1);
+		Q = state[0];
+	}
+
+	void forecast(const double *pval, std::size_t k, double *alphai) const {
+		forecast_copy(*this, pval, k, alphai);
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this);
+	}
+
+private:
+	GammaSeq g;
+	double alpha, lambda, tau;
+	index_t Q = 0;
+};
+
+class AlphaSpending final : public Procedure {
+public:
+	explicit AlphaSpending(const ProcedureSpec &s) : g(s.gammai), alpha(s.alpha) {}
+
+	double level() const {
+		return alpha * g[i];
+	}
+
+	void observe(double, bool, bool, bool) {
+		i++;
+	}
+
+	std::vector<double> state() const {
+		return {(double)i};
+	}
+
+	void restore(const std::vector<double> &state) {
+		check_state(state, 1);
+		i = state[0];
+	}
+
+	void forecast(const double *pval, std::size_t k, double *alphai) const {
+		forecast_copy(*this, pval, k, alphai);
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this);
+	}
+
+private:
+	GammaSeq g;
+	double alpha;
+	index_t i = 0;
+};
+
+class OnlineFallback final : public Procedure {
+public:
+	explicit OnlineFallback(const ProcedureSpec &s) : g(s.gammai), alpha(s.alpha) {}
+
+	double level() const {
+		return alpha * g[i] + carry;
+	}
+
+	void observe(double alphai, bool rejected, bool, bool) {
+		carry = rejected ? alphai : 0;
+		i++;
+	}
+
+	std::vector<double> state() const {
+		return {(double)i, carry};
+	}
+
+	void restore(const std::vector<double> &state) {
+		check_state(state, 2);
+		i = state[0];
+		carry = state[1];
+	}
+
+	void forecast(const double *pval, std::size_t k, double *alphai) const {
+		forecast_copy(*this, pval, k, alphai);
+	}
+
+	std::size_t memory() const {
+		return sizeof(*this);
+	}
+
+private:
+	GammaSeq g;
+	double alpha;
+	index_t i = 0;
+	double carry = 0;
+};
+
+// Procedure names match the R functions; LORD versions follow lord_faster
+// (1 = '++', 2 = 'discard', 3 = 3, 4 = 'dep'). Returns nullptr if unknown.
+inline std::unique_ptr<Procedure> make_procedure(const ProcedureSpec &s) {
+	const std::string &p = s.procedure;
+	if (p == "LORD") {
+		switch (s.version) {
+		case 1: return std::unique_ptr<Procedure>(new LordPlus(s));
+		case 2: return std::unique_ptr<Procedure>(new LordDiscard(s));
+		case 3: return std::unique_ptr<Procedure>(new LordWealth(s, false));
+		case 4: return std::unique_ptr<Procedure>(new LordWealth(s, true));
+		}
+	} else if (p == "LOND") {
+		return std::unique_ptr<Procedure>(new Lond(s));
+	} else if (p == "SAFFRON") {
+		return std::unique_ptr<Procedure>(new Saffron(s));
+	} else if (p == "ADDIS") {
+		return std::unique_ptr<Procedure>(new Addis(s));
+	} else if (p == "Alpha_investing") {
+		return std::unique_ptr<Procedure>(new AlphaInvesting(s));
+	} else if (p == "ADDIS_spending") {
+		return std::unique_ptr<Procedure>(new AddisSpending(s));
+	} else if (p == "Alpha_spending") {
+		return std::unique_ptr<Procedure>(new AlphaSpending(s));
+	} else if (p == "online_fallback") {
+		return std::unique_ptr<Procedure>(new OnlineFallback(s));
+	}
+	return std::unique_ptr<Procedure>();
+}
+
+// Calls f(proc) with a procedure of the concrete type named by s, so the
+// calls f makes on it are resolved at compile time. Returns false if unknown.
+template <class F>
+bool visit_procedure(const ProcedureSpec &s, F &f) {
+	const std::string &p = s.procedure;
+	if (p == "LORD") {
+		switch (s.version) {
+		case 1: { LordPlus proc(s); f(proc); return true; }
+		case 2: { LordDiscard proc(s); f(proc); return true; }
+		case 3: { LordWealth proc(s, false); f(proc); return true; }
+		case 4: { LordWealth proc(s, true); f(proc); return true; }
+		}
+	} else if (p == "LOND") {
+		Lond proc(s); f(proc); return true;
+	} else if (p == "SAFFRON") {
+		Saffron proc(s); f(proc); return true;
+	} else if (p == "ADDIS") {
+		Addis proc(s); f(proc); return true;
+	} else if (p == "Alpha_investing") {
+		AlphaInvesting proc(s); f(proc); return true;
+	} else if (p == "ADDIS_spending") {
+		AddisSpending proc(s); f(proc); return true;
+	} else if (p == "Alpha_spending") {
+		AlphaSpending proc(s); f(proc); return true;
+	} else if (p == "online_fallback") {
+		OnlineFallback proc(s); f(proc); return true;
+	}
+	return false;
+}
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef ONLINEFDR_RADIX_H
+#define ONLINEFDR_RADIX_H
+
+// Stable ordering of integer keys, such as dates as day numbers, by an LSD
+// radix sort on 16-bit digits of key - min. Keys spanning fewer than 2^16
+// values (any 179 years of dates) take a single counting pass.
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+namespace onlinefdr {
+
+// Returns true if key is already in non-decreasing order, in which case
+// order is left empty; otherwise order holds the stable sorting permutation.
+inline bool radix_order(const std::vector<int> &key, std::vector<std::ptrdiff_t> &order) {
+	std::ptrdiff_t n = key.size();
+	order.clear();
+	if (std::is_sorted(key.begin(), key.end()))
+		return true;
+
+	int lo = *std::min_element(key.begin(), key.end());
+	int hi = *std::max_element(key.begin(), key.end());
+	uint32_t span = (uint32_t)((int64_t)hi - lo);
+	int passes = span >> 16 ? 2 : 1;
+
+	std::vector<std::ptrdiff_t> from(n);
+	for (std::ptrdiff_t i = 0; i < n; i++)
+		from[i] = i;
+	order.resize(n);
+
+	for (int pass = 0; pass < passes; pass++) {
+		int shift = 16 * pass;
+		std::vector<std::ptrdiff_t> count((1 << 16) + 1, 0);
+		for (std::ptrdiff_t i = 0; i < n; i++)
+			count[(((uint32_t)((int64_t)key[i] - lo) >> shift) & 0xFFFF) + 1]++;
+		for (int d = 0; d < (1 << 16); d++)
+			count[d+1] += count[d];
+		for (std::ptrdiff_t i = 0; i < n; i++) {
+			std::ptrdiff_t j = from[i];
+			order[count[((uint32_t)((int64_t)key[j] - lo) >> shift) & 0xFFFF]++] = j;
+		}
+		if (pass + 1 < passes)
+			from.swap(order);
+	}
+	return false;
+}
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef ONLINEFDR_REGISTRY_H
+#define ONLINEFDR_REGISTRY_H
+
+// Many named streams of tests updated from many threads. Streams are kept
+// in shards, each a hash map behind its own mutex that is held only to find
+// a stream, and every stream has a mutex of its own held while its tests
+// run. Appends to different streams therefore proceed in parallel, and the
+// p-values of one append are tested in order without interleaving with
+// other appends to the same stream. Appends to one stream from several
+// threads are applied in the order they take its lock, so producers that
+// need a fixed order should each own their streams.
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include "procedures.h"
+#include "stream.h"
+
+namespace onlinefdr {
+
+class StreamRegistry {
+public:
+	struct Usage {
+		std::string id;
+		std::size_t tests;
+		std::size_t bytes;
+	};
+
+	explicit StreamRegistry(std::size_t shards = 64) : shards(shards ? shards : 1) {}
+
+	// Opens stream id, unless it is open already. A gamma table in s must
+	// outlive the stream. Throws std::invalid_argument for an unknown
+	// procedure.
+	bool open(const std::string &id, const ProcedureSpec &s) {
+		std::shared_ptr<Entry> e(new Entry);
+		e->proc = make_procedure(s);
+		if (!e->proc)
+			throw std::invalid_argument("Unknown procedure '" + s.procedure + "'.");
+		Shard &sh = shard(id);
+		std::lock_guard<std::mutex> guard(sh.lock);
+		return sh.streams.emplace(id, e).second;
+	}
+
+	bool close(const std::string &id) {
+		Shard &sh = shard(id);
+		std::lock_guard<std::mutex> guard(sh.lock);
+		return sh.streams.erase(id) > 0;
+	}
+
+	// Tests n p-values on stream id in order, writing the levels to alphai
+	// and the decisions to R where these are not null, and returns the
+	// number of rejections. Throws std::out_of_range if id is not open.
+	template <class Decision>
+	std::size_t append(const std::string &id, const double *pval, std::size_t n,
+		double *alphai, Decision *R) {
+		std::shared_ptr<Entry> e = find(id);
+		std::lock_guard<std::mutex> guard(e->lock);
+		e->tests += n;
+		return run(*e->proc, pval, n, alphai, R);
+	}
+
+	bool append(const std::string &id, double pval, double &alphai) {
+		std::shared_ptr<Entry> e = find(id);
+		std::lock_guard<std::mutex> guard(e->lock);
+		e->tests++;
+		return e->proc->test(pval, alphai);
+	}
+
+	// Level the next test of stream id would get.
+	double level(const std::string &id) const {
+		std::shared_ptr<Entry> e = find(id);
+		std::lock_guard<std::mutex> guard(e->lock);
+		return e->proc->level();
+	}
+
+	// Levels the next k tests of stream id would get if their p-values were
+	// pval, as Procedure::forecast. The stream is planned for k tests, so
+	// this and later forecasts of as many tests take time independent of
+	// its history.
+	void forecast(const std::string &id, const double *pval, std::size_t k, double *alphai) {
+		std::shared_ptr<Entry> e = find(id);
+		std::lock_guard<std::mutex> guard(e->lock);
+		e->proc->plan(k);
+		e->proc->forecast(pval, k, alphai);
+	}
+
+	// Bytes held for stream id: its procedure, history and entry.
+	std::size_t memory(const std::string &id) const {
+		std::shared_ptr<Entry> e = find(id);
+		std::lock_guard<std::mutex> guard(e->lock);
+		return bytes(id, *e);
+	}
+
+	std::size_t size() const {
+		std::size_t n = 0;
+		for (const Shard &sh : shards) {
+			std::lock_guard<std::mutex> guard(sh.lock);
+			n += sh.streams.size();
+		}
+		return n;
+	}
+
+	// Tests and bytes of every open stream, one shard at a time.
+	std::vector<Usage> usage() const {
+		std::vector<Usage> out;
+		for (const Shard &sh : shards) {
+			std::lock_guard<std::mutex> guard(sh.lock);
+			for (const auto &it : sh.streams) {
+				std::lock_guard<std::mutex> entry(it.second->lock);
+				out.push_back({it.first, it.second->tests, bytes(it.first, *it.second)});
+			}
+		}
+		return out;
+	}
+
+private:
+	struct Entry {
+		mutable std::mutex lock;
+		std::unique_ptr<Procedure> proc;
+		std::size_t tests = 0;
+	};
+
+	struct Shard {
+		mutable std::mutex lock;
+		std::unordered_map<std::string, std::shared_ptr<Entry> > streams;
+	};
+
+	Shard &shard(const std::string &id) {
+		return shards[std::hash<std::string>()(id) % shards.size()];
+	}
+
+	const Shard &shard(const std::string &id) const {
+		return shards[std::hash<std::string>()(id) % shards.size()];
+	}
+
+	// The entry stays alive while in use, even if the stream is closed.
+	std::shared_ptr<Entry> find(const std::string &id) const {
+		const Shard &sh = shard(id);
+		std::lock_guard<std::mutex> guard(sh.lock);
+		auto it = sh.streams.find(id);
+		if (it == sh.streams.end())
+			throw std::out_of_range("No stream '" + id + "'.");
+		return it->second;
+	}
+
+	static std::size_t bytes(const std::string &id, const Entry &e) {
+		return e.proc->memory() + sizeof(Entry) + id.capacity() +
+			sizeof(std::shared_ptr<Entry>);
+	}
+
+	std::vector<Shard> shards;
+};
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef ONLINEFDR_SINK_H
+#define ONLINEFDR_SINK_H
+
+// Running a procedure over a stream of unknown length in fixed-size chunks.
+// P-values are pulled from a source and the levels and decisions of each
+// chunk are pushed to a sink before the next chunk is read, so the memory
+// used is that of the procedure and of one chunk, however long the stream.
+
+#include <cstdio>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include "procedures.h"
+#include "stream.h"
+#include "stats.h"
+
+namespace onlinefdr {
+
+// The tests start, ..., start+n-1 of a stream (counted from 0). The
+// pointers are valid only during the call to the sink.
+struct Chunk {
+	index_t start;
+	std::size_t n;
+	const double *pval;
+	const double *alphai;
+	const unsigned char *R;  // 1 if rejected
+};
+
+// Tests the p-values of source in chunks of up to size. source(buf, max)
+// stores up to max p-values in buf and returns how many, 0 at the end of
+// the stream; sink(chunk) receives the results of each chunk. Work is
+// counted in c if given. Returns the number of tests.
+template <class Proc, class Source, class Sink>
+index_t run_chunks(Proc &proc, Source &source, std::size_t size, Sink &sink,
+	Counters *c = nullptr) {
+	std::vector<double> pval(size), alphai(size);
+	std::vector<unsigned char> R(size);
+	if (c)
+		c->allocate(size*(2*sizeof(double) + 1), 3);
+
+	index_t start = 0;
+	for (;;) {
+		std::size_t n = source(pval.data(), size);
+		if (n == 0)
+			break;
+		if (c)
+			run(proc, pval.data(), n, alphai.data(), R.data(), *c);
+		else
+			run(proc, pval.data(), n, alphai.data(), R.data());
+		Chunk chunk = {start, n, pval.data(), alphai.data(), R.data()};
+		sink(chunk);
+		start += n;
+	}
+	return start;
+}
+
+// A sink writing the chunks to a text file as lines "index,pval,alphai,R",
+// with the index counted from 1, under a header line. The file is not
+// closed. Throws std::runtime_error if it cannot be written.
+class CsvSink {
+public:
+	explicit CsvSink(std::FILE *f) : f(f) {
+		if (std::fputs("index,pval,alphai,R\n", f) < 0)
+			throw std::runtime_error("Cannot write the results.");
+	}
+
+	void operator()(const Chunk &c) {
+		for (std::size_t k = 0; k < c.n; k++)
+			if (std::fprintf(f, "%.0f,%.17g,%.17g,%d\n", (double)(c.start + k + 1), c.pval[k],
+				c.alphai[k], (int)c.R[k]) < 0)
+				throw std::runtime_error("Cannot write the results.");
+	}
+
+private:
+	std::FILE *f;
+};
+
+} // namespace onlinefdr
+
+#endif
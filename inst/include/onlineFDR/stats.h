@@ -0,0 +1,89 @@
+#ifndef ONLINEFDR_STATS_H
+#define ONLINEFDR_STATS_H
+
+// Counters of the work done while testing a stream, to find where the time
+// of a slow run goes. Only the overloads of step() and run() that take
+// Counters keep them, so runs without them compile to the plain loops and
+// pay nothing.
+
+#include <cstddef>
+#include <algorithm>
+#include "procedures.h"
+#include "stream.h"
+
+namespace onlinefdr {
+
+// Counts are doubles, which are exact up to 2^53 and go to R as they are.
+struct Counters {
+	double tests = 0;
+	double rejections = 0;
+	// iterations of the inner loops, such as the sum over past rejections
+	double iterations = 0;
+	// largest number of past rejections a level depended on
+	double peak_history = 0;
+	// times the history grew its storage, and by how many bytes
+	double allocations = 0;
+	double allocated_bytes = 0;
+	// bytes of input, output and history read or written
+	double touched_bytes = 0;
+
+	// Records one test whose level took the given number of iterations.
+	void test(double iterations, double history, double bytes) {
+		tests++;
+		this->iterations += iterations;
+		peak_history = std::max(peak_history, history);
+		touched_bytes += bytes;
+	}
+
+	void allocate(double bytes, double n = 1) {
+		allocations += n;
+		allocated_bytes += bytes;
+	}
+
+	Counters &operator+=(const Counters &c) {
+		tests += c.tests;
+		rejections += c.rejections;
+		iterations += c.iterations;
+		peak_history = std::max(peak_history, c.peak_history);
+		allocations += c.allocations;
+		allocated_bytes += c.allocated_bytes;
+		touched_bytes += c.touched_bytes;
+		return *this;
+	}
+};
+
+// step() that also counts its work in c.
+template <class Proc>
+inline bool step(Proc &proc, double pval, double &alphai, Counters &c) {
+	std::size_t k = proc.history();
+	std::size_t before = proc.memory();
+	bool rejected = step(proc, pval, alphai);
+	std::size_t after = proc.memory();
+	if (after > before)
+		c.allocate(after - before);
+	c.test(k, proc.history(), sizeof(double) + k*sizeof(index_t));
+	c.rejections += rejected;
+	return rejected;
+}
+
+// run() that also counts its work in c.
+template <class Proc, class Decision>
+std::size_t run(Proc &proc, const double *pval, std::size_t n, double *alphai, Decision *R,
+	Counters &c) {
+	std::size_t rejections = 0;
+	for (std::size_t i = 0; i < n; i++) {
+		double a;
+		bool rejected = step(proc, pval[i], a, c);
+		if (alphai)
+			alphai[i] = a;
+		if (R)
+			R[i] = rejected;
+		rejections += rejected;
+	}
+	c.touched_bytes += n*((alphai ? sizeof(double) : 0) + (R ? sizeof(Decision) : 0));
+	return rejections;
+}
+
+} // namespace onlinefdr
+
+#endif
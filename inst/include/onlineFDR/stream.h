@@ -0,0 +1,41 @@
+#ifndef ONLINEFDR_STREAM_H
+#define ONLINEFDR_STREAM_H
+
+// Driving a procedure over a stream of p-values through plain pointers.
+
+#include <cstddef>
+#include "procedures.h"
+
+namespace onlinefdr {
+
+// Tests one p-value: stores the level in alphai, records the outcome and
+// returns whether the hypothesis is rejected. Proc is the concrete type, so
+// the calls are resolved at compile time.
+template <class Proc>
+inline bool step(Proc &proc, double pval, double &alphai) {
+	alphai = proc.level();
+	bool rejected = (pval <= alphai);
+	proc.observe(alphai, rejected, pval <= proc.candidate(), pval <= proc.selection());
+	return rejected;
+}
+
+// Tests n p-values in order, writing the levels to alphai and the decisions
+// (1 or 0) to R where these are not null. Returns the number of rejections.
+template <class Proc, class Decision>
+std::size_t run(Proc &proc, const double *pval, std::size_t n, double *alphai, Decision *R) {
+	std::size_t rejections = 0;
+	for (std::size_t i = 0; i < n; i++) {
+		double a;
+		bool rejected = step(proc, pval[i], a);
+		if (alphai)
+			alphai[i] = a;
+		if (R)
+			R[i] = rejected;
+		rejections += rejected;
+	}
+	return rejections;
+}
+
+} // namespace onlinefdr
+
+#endif
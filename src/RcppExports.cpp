@@ -11,13 +11,13 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // addis_sync_faster
-DataFrame addis_sync_faster(NumericVector pval, NumericVector gammai, double lambda, double alpha, double tau, double w0, bool display_progress);
+List addis_sync_faster(NumericVector pval, SEXP gammai, double lambda, double alpha, double tau, double w0, bool display_progress);
 RcppExport SEXP _onlineFDR_addis_sync_faster(SEXP pvalSEXP, SEXP gammaiSEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP tauSEXP, SEXP w0SEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
-    Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< double >::type tau(tauSEXP);
@@ -28,7 +28,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // addis_async_faster
-DataFrame addis_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double lambda, double alpha, double tau, double w0, bool display_progress);
+List addis_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double lambda, double alpha, double tau, double w0, bool display_progress);
 RcppExport SEXP _onlineFDR_addis_async_faster(SEXP pvalSEXP, SEXP ESEXP, SEXP gammaiSEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP tauSEXP, SEXP w0SEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -46,7 +46,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // addis_spending_faster
-DataFrame addis_spending_faster(NumericVector pval, NumericVector gammai, double alpha, double lambda, double tau, bool display_progress);
+List addis_spending_faster(NumericVector pval, NumericVector gammai, double alpha, double lambda, double tau, bool display_progress);
 RcppExport SEXP _onlineFDR_addis_spending_faster(SEXP pvalSEXP, SEXP gammaiSEXP, SEXP alphaSEXP, SEXP lambdaSEXP, SEXP tauSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -62,7 +62,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // addis_spending_dep_faster
-DataFrame addis_spending_dep_faster(NumericVector pval, IntegerVector L, NumericVector gammai, double alpha, double lambda, double tau, bool display_progress);
+List addis_spending_dep_faster(NumericVector pval, IntegerVector L, NumericVector gammai, double alpha, double lambda, double tau, bool display_progress);
 RcppExport SEXP _onlineFDR_addis_spending_dep_faster(SEXP pvalSEXP, SEXP LSEXP, SEXP gammaiSEXP, SEXP alphaSEXP, SEXP lambdaSEXP, SEXP tauSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -78,14 +78,31 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// addis_spending_async_faster
+List addis_spending_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double alpha, double lambda, double tau, bool display_progress);
+RcppExport SEXP _onlineFDR_addis_spending_async_faster(SEXP pvalSEXP, SEXP ESEXP, SEXP gammaiSEXP, SEXP alphaSEXP, SEXP lambdaSEXP, SEXP tauSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type E(ESEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< double >::type tau(tauSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(addis_spending_async_faster(pval, E, gammai, alpha, lambda, tau, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
 // alphainvesting_faster
-DataFrame alphainvesting_faster(NumericVector pval, NumericVector gammai, double alpha, double w0, bool display_progress);
+List alphainvesting_faster(NumericVector pval, SEXP gammai, double alpha, double w0, bool display_progress);
 RcppExport SEXP _onlineFDR_alphainvesting_faster(SEXP pvalSEXP, SEXP gammaiSEXP, SEXP alphaSEXP, SEXP w0SEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
-    Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
     Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< double >::type w0(w0SEXP);
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
@@ -93,8 +110,164 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// batch_faster
+List batch_faster(NumericVector pval, NumericVector sizes, NumericVector gammai, std::string procedure, double alpha, double lambda, bool provisional, bool display_progress);
+RcppExport SEXP _onlineFDR_batch_faster(SEXP pvalSEXP, SEXP sizesSEXP, SEXP gammaiSEXP, SEXP procedureSEXP, SEXP alphaSEXP, SEXP lambdaSEXP, SEXP provisionalSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type sizes(sizesSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< std::string >::type procedure(procedureSEXP);
+    Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
+    Rcpp::traits::input_parameter< bool >::type provisional(provisionalSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(batch_faster(pval, sizes, gammai, procedure, alpha, lambda, provisional, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// chunks_faster
+NumericVector chunks_faster(SEXP source, List spec, SEXP gammai, double size, SEXP sink, std::string path);
+RcppExport SEXP _onlineFDR_chunks_faster(SEXP sourceSEXP, SEXP specSEXP, SEXP gammaiSEXP, SEXP sizeSEXP, SEXP sinkSEXP, SEXP pathSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type source(sourceSEXP);
+    Rcpp::traits::input_parameter< List >::type spec(specSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< double >::type size(sizeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type sink(sinkSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    rcpp_result_gen = Rcpp::wrap(chunks_faster(source, spec, gammai, size, sink, path));
+    return rcpp_result_gen;
+END_RCPP
+}
+// decisions_faster
+SEXP decisions_faster(NumericVector pval, List spec, SEXP gammai, bool bits, bool thresholds, bool display_progress);
+RcppExport SEXP _onlineFDR_decisions_faster(SEXP pvalSEXP, SEXP specSEXP, SEXP gammaiSEXP, SEXP bitsSEXP, SEXP thresholdsSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< List >::type spec(specSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< bool >::type bits(bitsSEXP);
+    Rcpp::traits::input_parameter< bool >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(decisions_faster(pval, spec, gammai, bits, thresholds, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// file_faster
+NumericVector file_faster(std::string input, std::string output, std::string thresholds, List spec, SEXP gammai, bool display_progress);
+RcppExport SEXP _onlineFDR_file_faster(SEXP inputSEXP, SEXP outputSEXP, SEXP thresholdsSEXP, SEXP specSEXP, SEXP gammaiSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type input(inputSEXP);
+    Rcpp::traits::input_parameter< std::string >::type output(outputSEXP);
+    Rcpp::traits::input_parameter< std::string >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< List >::type spec(specSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(file_faster(input, output, thresholds, spec, gammai, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// forecast_faster
+NumericVector forecast_faster(NumericVector pval, List spec, SEXP gammai, NumericVector assumed, NumericVector state);
+RcppExport SEXP _onlineFDR_forecast_faster(SEXP pvalSEXP, SEXP specSEXP, SEXP gammaiSEXP, SEXP assumedSEXP, SEXP stateSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< List >::type spec(specSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type assumed(assumedSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type state(stateSEXP);
+    rcpp_result_gen = Rcpp::wrap(forecast_faster(pval, spec, gammai, assumed, state));
+    return rcpp_result_gen;
+END_RCPP
+}
+// fused_faster
+List fused_faster(NumericVector pval, List specs, List gammai, bool display_progress);
+RcppExport SEXP _onlineFDR_fused_faster(SEXP pvalSEXP, SEXP specsSEXP, SEXP gammaiSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< List >::type specs(specsSEXP);
+    Rcpp::traits::input_parameter< List >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(fused_faster(pval, specs, gammai, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gamma_sequence
+NumericVector gamma_sequence(std::string family, double n, double scale, bool normalise);
+RcppExport SEXP _onlineFDR_gamma_sequence(SEXP familySEXP, SEXP nSEXP, SEXP scaleSEXP, SEXP normaliseSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type n(nSEXP);
+    Rcpp::traits::input_parameter< double >::type scale(scaleSEXP);
+    Rcpp::traits::input_parameter< bool >::type normalise(normaliseSEXP);
+    rcpp_result_gen = Rcpp::wrap(gamma_sequence(family, n, scale, normalise));
+    return rcpp_result_gen;
+END_RCPP
+}
+// gamma_total
+double gamma_total(std::string family, double n);
+RcppExport SEXP _onlineFDR_gamma_total(SEXP familySEXP, SEXP nSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type family(familySEXP);
+    Rcpp::traits::input_parameter< double >::type n(nSEXP);
+    rcpp_result_gen = Rcpp::wrap(gamma_total(family, n));
+    return rcpp_result_gen;
+END_RCPP
+}
+// pval_status
+int pval_status(NumericVector pval);
+RcppExport SEXP _onlineFDR_pval_status(SEXP pvalSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    rcpp_result_gen = Rcpp::wrap(pval_status(pval));
+    return rcpp_result_gen;
+END_RCPP
+}
+// date_order
+SEXP date_order(NumericVector date, bool random);
+RcppExport SEXP _onlineFDR_date_order(SEXP dateSEXP, SEXP randomSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type date(dateSEXP);
+    Rcpp::traits::input_parameter< bool >::type random(randomSEXP);
+    rcpp_result_gen = Rcpp::wrap(date_order(date, random));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_pvals_faster
+List read_pvals_faster(std::string path, std::string sep);
+RcppExport SEXP _onlineFDR_read_pvals_faster(SEXP pathSEXP, SEXP sepSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type sep(sepSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_pvals_faster(path, sep));
+    return rcpp_result_gen;
+END_RCPP
+}
 // lond_faster
-DataFrame lond_faster(NumericVector pval, NumericVector betai, double alpha, bool original, bool display_progress);
+List lond_faster(NumericVector pval, NumericVector betai, double alpha, bool original, bool display_progress);
 RcppExport SEXP _onlineFDR_lond_faster(SEXP pvalSEXP, SEXP betaiSEXP, SEXP alphaSEXP, SEXP originalSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -109,7 +282,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // londstar_async_faster
-DataFrame londstar_async_faster(NumericVector pval, IntegerVector E, NumericVector betai, double alpha, bool display_progress);
+List londstar_async_faster(NumericVector pval, IntegerVector E, NumericVector betai, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_londstar_async_faster(SEXP pvalSEXP, SEXP ESEXP, SEXP betaiSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -124,7 +297,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // londstar_dep_faster
-DataFrame londstar_dep_faster(NumericVector pval, IntegerVector L, NumericVector betai, double alpha, bool display_progress);
+List londstar_dep_faster(NumericVector pval, IntegerVector L, NumericVector betai, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_londstar_dep_faster(SEXP pvalSEXP, SEXP LSEXP, SEXP betaiSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -139,14 +312,14 @@ BEGIN_RCPP
 END_RCPP
 }
 // londstar_batch_faster
-List londstar_batch_faster(NumericVector pval, IntegerVector batch, IntegerVector batchsum, NumericVector betai, double alpha, bool display_progress);
+List londstar_batch_faster(NumericVector pval, IntegerVector batch, NumericVector batchsum, NumericVector betai, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_londstar_batch_faster(SEXP pvalSEXP, SEXP batchSEXP, SEXP batchsumSEXP, SEXP betaiSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type batch(batchSEXP);
-    Rcpp::traits::input_parameter< IntegerVector >::type batchsum(batchsumSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type batchsum(batchsumSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type betai(betaiSEXP);
     Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
@@ -155,13 +328,13 @@ BEGIN_RCPP
 END_RCPP
 }
 // lord_faster
-DataFrame lord_faster(NumericVector pval, NumericVector gammai, int version, double alpha, double w0, double b0, double taudiscard, bool display_progress);
+List lord_faster(NumericVector pval, SEXP gammai, int version, double alpha, double w0, double b0, double taudiscard, bool display_progress);
 RcppExport SEXP _onlineFDR_lord_faster(SEXP pvalSEXP, SEXP gammaiSEXP, SEXP versionSEXP, SEXP alphaSEXP, SEXP w0SEXP, SEXP b0SEXP, SEXP taudiscardSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
-    Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
     Rcpp::traits::input_parameter< int >::type version(versionSEXP);
     Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< double >::type w0(w0SEXP);
@@ -173,7 +346,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // lordstar_async_faster
-DataFrame lordstar_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double w0, double alpha, bool display_progress);
+List lordstar_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double w0, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_lordstar_async_faster(SEXP pvalSEXP, SEXP ESEXP, SEXP gammaiSEXP, SEXP w0SEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -189,7 +362,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // lordstar_dep_faster
-DataFrame lordstar_dep_faster(NumericVector pval, IntegerVector L, NumericVector gammai, double w0, double alpha, bool display_progress);
+List lordstar_dep_faster(NumericVector pval, IntegerVector L, NumericVector gammai, double w0, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_lordstar_dep_faster(SEXP pvalSEXP, SEXP LSEXP, SEXP gammaiSEXP, SEXP w0SEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -205,14 +378,14 @@ BEGIN_RCPP
 END_RCPP
 }
 // lordstar_batch_faster
-List lordstar_batch_faster(NumericVector pval, IntegerVector batch, IntegerVector batchsum, NumericVector gammai, double w0, double alpha, bool display_progress);
+List lordstar_batch_faster(NumericVector pval, IntegerVector batch, NumericVector batchsum, NumericVector gammai, double w0, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_lordstar_batch_faster(SEXP pvalSEXP, SEXP batchSEXP, SEXP batchsumSEXP, SEXP gammaiSEXP, SEXP w0SEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type batch(batchSEXP);
-    Rcpp::traits::input_parameter< IntegerVector >::type batchsum(batchsumSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type batchsum(batchsumSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
     Rcpp::traits::input_parameter< double >::type w0(w0SEXP);
     Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
@@ -222,7 +395,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // online_fallback_faster
-DataFrame online_fallback_faster(NumericVector pval, NumericVector gammai, double alpha, bool display_progress);
+List online_fallback_faster(NumericVector pval, NumericVector gammai, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_online_fallback_faster(SEXP pvalSEXP, SEXP gammaiSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -235,14 +408,32 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// replay_faster
+NumericVector replay_faster(NumericVector pval, IntegerVector batch, List spec, SEXP gammai, int nperm, int seed, int ncores, bool display_progress);
+RcppExport SEXP _onlineFDR_replay_faster(SEXP pvalSEXP, SEXP batchSEXP, SEXP specSEXP, SEXP gammaiSEXP, SEXP npermSEXP, SEXP seedSEXP, SEXP ncoresSEXP, SEXP display_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type batch(batchSEXP);
+    Rcpp::traits::input_parameter< List >::type spec(specSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< int >::type nperm(npermSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< int >::type ncores(ncoresSEXP);
+    Rcpp::traits::input_parameter< bool >::type display_progress(display_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(replay_faster(pval, batch, spec, gammai, nperm, seed, ncores, display_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
 // saffron_faster
-DataFrame saffron_faster(NumericVector pval, NumericVector gammai, double lambda, double alpha, double w0, bool display_progress);
+List saffron_faster(NumericVector pval, SEXP gammai, double lambda, double alpha, double w0, bool display_progress);
 RcppExport SEXP _onlineFDR_saffron_faster(SEXP pvalSEXP, SEXP gammaiSEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP w0SEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
-    Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
     Rcpp::traits::input_parameter< double >::type alpha(alphaSEXP);
     Rcpp::traits::input_parameter< double >::type w0(w0SEXP);
@@ -252,7 +443,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // saffronstar_async_faster
-DataFrame saffronstar_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double w0, double lambda, double alpha, bool display_progress);
+List saffronstar_async_faster(NumericVector pval, IntegerVector E, NumericVector gammai, double w0, double lambda, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_saffronstar_async_faster(SEXP pvalSEXP, SEXP ESEXP, SEXP gammaiSEXP, SEXP w0SEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -269,7 +460,7 @@ BEGIN_RCPP
 END_RCPP
 }
 // saffronstar_dep_faster
-DataFrame saffronstar_dep_faster(NumericVector pval, IntegerVector L, NumericVector gammai, double w0, double lambda, double alpha, bool display_progress);
+List saffronstar_dep_faster(NumericVector pval, IntegerVector L, NumericVector gammai, double w0, double lambda, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_saffronstar_dep_faster(SEXP pvalSEXP, SEXP LSEXP, SEXP gammaiSEXP, SEXP w0SEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
@@ -286,14 +477,14 @@ BEGIN_RCPP
 END_RCPP
 }
 // saffronstar_batch_faster
-List saffronstar_batch_faster(NumericVector pval, IntegerVector batch, IntegerVector batchsum, NumericVector gammai, double w0, double lambda, double alpha, bool display_progress);
+List saffronstar_batch_faster(NumericVector pval, IntegerVector batch, NumericVector batchsum, NumericVector gammai, double w0, double lambda, double alpha, bool display_progress);
 RcppExport SEXP _onlineFDR_saffronstar_batch_faster(SEXP pvalSEXP, SEXP batchSEXP, SEXP batchsumSEXP, SEXP gammaiSEXP, SEXP w0SEXP, SEXP lambdaSEXP, SEXP alphaSEXP, SEXP display_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
     Rcpp::traits::input_parameter< IntegerVector >::type batch(batchSEXP);
-    Rcpp::traits::input_parameter< IntegerVector >::type batchsum(batchsumSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type batchsum(batchsumSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type gammai(gammaiSEXP);
     Rcpp::traits::input_parameter< double >::type w0(w0SEXP);
     Rcpp::traits::input_parameter< double >::type lambda(lambdaSEXP);
@@ -303,13 +494,50 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// simd_level
+std::string simd_level(std::string level);
+RcppExport SEXP _onlineFDR_simd_level(SEXP levelSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type level(levelSEXP);
+    rcpp_result_gen = Rcpp::wrap(simd_level(level));
+    return rcpp_result_gen;
+END_RCPP
+}
+// update_faster
+List update_faster(NumericVector pval, List spec, SEXP gammai, NumericVector state);
+RcppExport SEXP _onlineFDR_update_faster(SEXP pvalSEXP, SEXP specSEXP, SEXP gammaiSEXP, SEXP stateSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type pval(pvalSEXP);
+    Rcpp::traits::input_parameter< List >::type spec(specSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type gammai(gammaiSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type state(stateSEXP);
+    rcpp_result_gen = Rcpp::wrap(update_faster(pval, spec, gammai, state));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
     {"_onlineFDR_addis_sync_faster", (DL_FUNC) &_onlineFDR_addis_sync_faster, 7},
     {"_onlineFDR_addis_async_faster", (DL_FUNC) &_onlineFDR_addis_async_faster, 8},
     {"_onlineFDR_addis_spending_faster", (DL_FUNC) &_onlineFDR_addis_spending_faster, 6},
     {"_onlineFDR_addis_spending_dep_faster", (DL_FUNC) &_onlineFDR_addis_spending_dep_faster, 7},
+    {"_onlineFDR_addis_spending_async_faster", (DL_FUNC) &_onlineFDR_addis_spending_async_faster, 7},
     {"_onlineFDR_alphainvesting_faster", (DL_FUNC) &_onlineFDR_alphainvesting_faster, 5},
+    {"_onlineFDR_batch_faster", (DL_FUNC) &_onlineFDR_batch_faster, 8},
+    {"_onlineFDR_chunks_faster", (DL_FUNC) &_onlineFDR_chunks_faster, 6},
+    {"_onlineFDR_decisions_faster", (DL_FUNC) &_onlineFDR_decisions_faster, 6},
+    {"_onlineFDR_file_faster", (DL_FUNC) &_onlineFDR_file_faster, 6},
+    {"_onlineFDR_forecast_faster", (DL_FUNC) &_onlineFDR_forecast_faster, 5},
+    {"_onlineFDR_fused_faster", (DL_FUNC) &_onlineFDR_fused_faster, 4},
+    {"_onlineFDR_gamma_sequence", (DL_FUNC) &_onlineFDR_gamma_sequence, 4},
+    {"_onlineFDR_gamma_total", (DL_FUNC) &_onlineFDR_gamma_total, 2},
+    {"_onlineFDR_pval_status", (DL_FUNC) &_onlineFDR_pval_status, 1},
+    {"_onlineFDR_date_order", (DL_FUNC) &_onlineFDR_date_order, 2},
+    {"_onlineFDR_read_pvals_faster", (DL_FUNC) &_onlineFDR_read_pvals_faster, 2},
     {"_onlineFDR_lond_faster", (DL_FUNC) &_onlineFDR_lond_faster, 5},
     {"_onlineFDR_londstar_async_faster", (DL_FUNC) &_onlineFDR_londstar_async_faster, 5},
     {"_onlineFDR_londstar_dep_faster", (DL_FUNC) &_onlineFDR_londstar_dep_faster, 5},
@@ -319,10 +547,13 @@ static const R_CallMethodDef CallEntries[] = {
     {"_onlineFDR_lordstar_dep_faster", (DL_FUNC) &_onlineFDR_lordstar_dep_faster, 6},
     {"_onlineFDR_lordstar_batch_faster", (DL_FUNC) &_onlineFDR_lordstar_batch_faster, 7},
     {"_onlineFDR_online_fallback_faster", (DL_FUNC) &_onlineFDR_online_fallback_faster, 4},
+    {"_onlineFDR_replay_faster", (DL_FUNC) &_onlineFDR_replay_faster, 8},
     {"_onlineFDR_saffron_faster", (DL_FUNC) &_onlineFDR_saffron_faster, 6},
     {"_onlineFDR_saffronstar_async_faster", (DL_FUNC) &_onlineFDR_saffronstar_async_faster, 7},
     {"_onlineFDR_saffronstar_dep_faster", (DL_FUNC) &_onlineFDR_saffronstar_dep_faster, 7},
     {"_onlineFDR_saffronstar_batch_faster", (DL_FUNC) &_onlineFDR_saffronstar_batch_faster, 8},
+    {"_onlineFDR_simd_level", (DL_FUNC) &_onlineFDR_simd_level, 1},
+    {"_onlineFDR_update_faster", (DL_FUNC) &_onlineFDR_update_faster, 4},
     {NULL, NULL, 0}
 };
 
@@ -1,8 +1,12 @@
 // [[Rcpp::depends(RcppProgress)]]
 #include <progress.hpp>
 #include <progress_bar.hpp>
+#include "ticker.h"
 #include <vector>
 #include <algorithm>
+#include <onlineFDR/procedures.h>
+#include "spec.h"
+#include "pending.h"
 
 using namespace Rcpp;
 using std::endl;
@@ -24,120 +28,40 @@ using std::endl;
 // }
 
 // [[Rcpp::export]]
-DataFrame addis_sync_faster(NumericVector pval,
-	NumericVector gammai,
+List addis_sync_faster(NumericVector pval,
+	SEXP gammai,
 	double lambda = 0.25,
 	double alpha = 0.05,
 	double tau = 0.5,
 	double w0 = 0.025,
 	bool display_progress = true) {
-	int N = pval.size();
-
-	NumericVector alphai(N);
-	LogicalVector R(N);
-	IntegerVector Cjplus(N);
-	IntegerVector cand(N);
-	LogicalVector selected = (pval <= tau);
-	NumericVector S = cumsum(static_cast<NumericVector>(selected));
-
-	alphai[0] = std::min((tau-lambda)*gammai[0]*w0, lambda);
-	R[0] = (pval[0] <= alphai[0]);
-  
-	int K = sum(R);
-	int candsum = 0; 
-	IntegerVector kappai(1);
-
-	Progress p(N * N, display_progress);
-
-	for (int i = 1; i < N; i++) {
-
-		cand[i-1] = (pval[i-1] <= lambda);
-		candsum += cand[i-1];
-
-		double alphaitilde;
-
-		if (K > 1) {
 
-			if (R[i-1])
-				kappai.push_back(i-1);
+	onlinefdr::ProcedureSpec s;
+	NumericVector table;
+	s.gammai = as_gamma(gammai, table);
+	s.lambda = lambda;
+	s.alpha = alpha;
+	s.tau = tau;
+	s.w0 = w0;
 
-			//sapply 
-			NumericVector kappaistar(kappai.size());
-
-			int mysum = 0;
-			int index = 0;
-			int bound = kappai[kappai.size()-1];
-			for (int k = 0; k <= bound; k++) {
-				mysum += selected[k];
-		//this is the sapply workaround
-				if (kappai[index] == k){
-					kappaistar[index] = mysum;
-					index++;
-				}
-			}
-
-			//update Cjplus
-			double Cjplussum = 0;
-			for (int j = 0; j < K-1; j++) {
-				p.increment();
-				Cjplus[j] += cand[i-1];
-				Cjplussum += gammai[ S[i-1] - kappaistar[j] - Cjplus[j] ];
-			}
-
-	    	//update Cjplus again
-			Cjplus[K-1] = 0;
-			int low = kappai[K-1]+1;
-			int high = std::max(i-1, (int)(max(kappai) + 1));
-			for (int j = low; j <= high; j++) {
-				Cjplus[K-1] += cand[j];
-			}
-
-			Cjplussum += gammai[ S[i-1]-kappaistar[K-1]-Cjplus[K-1] ] - 
-			gammai[ S[i-1]-kappaistar[0]-Cjplus[0] ];
-
-			alphaitilde = (tau - lambda)*(w0*gammai[ S[i-1]-candsum ] + 
-			(alpha-w0)*gammai[ S[i-1]-kappaistar[0]-Cjplus[0] ] + alpha*Cjplussum);
-
-		} else if (K == 1) {
-
-			if (R[i-1])
-				kappai[0] = i-1;
-
-			int kappaistar = 0;
-			for (int j = 0; j <= kappai[0]; j++)
-				kappaistar += selected[j];
-
-			Cjplus[0] = 0;
-			int low = kappai[0]+1;
-			int high = std::max(i-1, kappai[0]+1);
-			for (int j = low; j <= high; j++) {
-				if (cand[j])
-					Cjplus[0]++;
-			}
-
-			alphaitilde = (tau - lambda)*(w0*gammai[ S[i-1] - candsum  ] + 
-			    (alpha-w0)*gammai[ S[i-1] - kappaistar - Cjplus[0] ]);
-
-		} else {
-
-			alphaitilde = (tau - lambda)*w0*gammai[ S[i-1] - candsum ];
-
-		}
-
-		alphai[i] = std::min(lambda, alphaitilde);
-		if (pval[i] <= alphai[i]) {
-			R[i] = 1;
-			K++;
-		}
-	}
-
-	return DataFrame::create(_["pval"] = pval,
-		_["alphai"] = alphai,
-		_["R"] = R);
+	onlinefdr::Addis proc(s);
+	return run_sequential(pval, proc, display_progress);
 }
 
+// The state of the asynchronous kernel is that of the rejections and of
+// the tests in flight, not of the whole stream: S, the candidates and the
+// selections of the known tests are running counts, kept up to date as the
+// tests become known. Each rejection keeps the number of selections up to
+// it (kappaistar) and the number of known candidates after it (Cjplus).
+struct AddisRejection {
+	R_xlen_t index;
+	R_xlen_t kappaistar;
+	R_xlen_t Cjplus;
+	bool known;
+};
+
 // [[Rcpp::export]]
-DataFrame addis_async_faster(NumericVector pval,
+List addis_async_faster(NumericVector pval,
 	IntegerVector E,
 	NumericVector gammai,
 	double lambda = 0.25,
@@ -146,128 +70,115 @@ DataFrame addis_async_faster(NumericVector pval,
 	double w0 = 0.025,
 	bool display_progress = false) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
-	LogicalVector R(N);
-	IntegerVector S(N);
-	IntegerVector cand(N);
-	IntegerVector Cjplus(N);
-	LogicalVector selected = (pval <= tau);
+	NumericVector R(N);
+
+	std::vector<AddisRejection> rejections;
+	onlinefdr::Pending pending;
+	// selections among all tests so far, and among the known ones
+	R_xlen_t selections = 0, selknown = 0;
+	R_xlen_t known = 0, candsum = 0, K = 0;
 
 	alphai[0] = std::min((tau-lambda)*w0*gammai[0], lambda);
 	R[0] = (pval[0] <= alphai[0]);
-
-	int K;
-	std::vector<int> kappai;
-
-	Progress p(N * N, display_progress);
-
-	for (int i = 1; i < N; i++) {
-
-		kappai.clear();
-		// nightmare to code the which statement
-		for (int j = 0; j <= i-1; j++) {
-			if (R[j] && (E[j]-1 <= i-1))
-				kappai.push_back(j);
+	stats.test(R[0], 0, 0, 3*sizeof(double));
+
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
+
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+
+		// record test i-1, then the tests that become known to test i
+		R_xlen_t last = i-1;
+		selections += (pval[last] <= tau);
+		if (R[last]) {
+			size_t capacity = rejections.capacity();
+			rejections.push_back({last, selections, 0, false});
+			if (rejections.capacity() != capacity)
+				stats.allocate(rejections.capacity()*sizeof(AddisRejection));
 		}
-
-		K = kappai.size();
-
-		cand[i-1] = (pval[i-1] <= lambda);
-
-		int candsum = 0;
-		//C++ trick to loop "seq_len" and use conditional incrementor for "sum"
-		for (int j = 0; j <= i-1; j++) {
-			if (cand[j] && (E[j]-1 <= i-1))
+		size_t capacity = pending.capacity();
+		pending.push(last, E[last]);
+		if (pending.capacity() != capacity)
+			stats.allocate(pending.capacity()*2*sizeof(R_xlen_t));
+
+		double updates = 0;
+		pending.release(i, [&](R_xlen_t j) {
+			known++;
+			selknown += (pval[j] <= tau);
+			if (pval[j] <= lambda) {
 				candsum++;
-		}
-
-		int Ssum = 0;
-		for (int j = 0; j <= i-1; j++) {
-			if (selected[j] && (E[j]-1 <= i-1))
-				Ssum++;
-			if (E[j]-1 >= i)
-				Ssum++;
-		}
+				// a known candidate counts for the rejections before it
+				for (AddisRejection &r : rejections) {
+					if (r.index >= j)
+						break;
+					r.Cjplus++;
+					updates++;
+				}
+			}
+			if (R[j]) {
+				auto r = std::lower_bound(rejections.begin(), rejections.end(), j,
+					[](const AddisRejection &r, R_xlen_t j) { return r.index < j; });
+				r->known = true;
+				K++;
+			}
+		});
 
-		S[i-1] = Ssum;
+		// the selected known tests and those not known yet
+		R_xlen_t S = selknown + (i - known);
 
 		double alphaitilde;
 		if (K > 1) {
 
-	    //sapply, also nightmare to code 
-			NumericVector kappaistar(kappai.size());
-
-			int mysum = 0;
-			int index = 0;
-			int bound = kappai[kappai.size()-1];
-			for (int k = 0; k <= bound; k++) {
-				mysum += selected[k];
-		//this is the sapply workaround
-				if (kappai[index] == k){
-					kappaistar[index] = mysum;
-					index++;
-				}
+			double Cjplussum = 0;
+			const AddisRejection *first = nullptr;
+			for (const AddisRejection &r : rejections) {
+				if (!r.known)
+					continue;
+				if (!first)
+					first = &r;
+				Cjplussum += gammai[ S - r.kappaistar - r.Cjplus ];
 			}
+			Cjplussum -= gammai[ S - first->kappaistar - first->Cjplus ];
 
-	    //update Cjplus
-			for (int j = 0; j < K; j++) {
-				p.increment();
+			alphaitilde = (tau-lambda)*(w0*gammai[ S-candsum ] +
+			(alpha-w0)*gammai[ S-first->kappaistar-first->Cjplus ] + alpha*Cjplussum);
 
-				int from = kappai[j]+1;
-				int to = std::max(i-1, kappai[j]+1);
-				int sum = 0;
-
-				for (int k = from; k <= to; k++) {
-					if (cand[k] && E[k]-1 <= i-1)
-						sum++;
-				}
-
-				Cjplus[j] = sum;
-			}
-
-			double Cjplussum = 0;
-			//indexing gammai is a nightmare
-			for (int j = 0; j < K; j++) {
-				Cjplussum += gammai[ S[i-1] - kappaistar[j] - Cjplus[j] ];
-			}
-			Cjplussum -= gammai[ S[i-1] - kappaistar[0] - Cjplus[0] ];
-			
-			alphaitilde = (tau-lambda)*(w0*gammai[ S[i-1]-candsum ] + 
-			(alpha-w0)*gammai[ S[i-1]-kappaistar[0]-Cjplus[0] ] + alpha*Cjplussum);
-			
 		}  else if (K == 1) {
 
-			int kappaistar = 0;
-			for (int j = 0; j <= kappai[0]; j++)
-				kappaistar += selected[j];
+			const AddisRejection *first = &rejections[0];
+			while (!first->known)
+				first++;
 
-			int from = kappai[0]+1;
-			int to = std::max(i-1, kappai[0]+1);
-			Cjplus[0] = 0;
-			for (int j = from; j <= to; j++) {
-				if (cand[j] && E[j]-1 <= i-1)
-					Cjplus[0]++;
-			}
+			alphaitilde = (tau-lambda)*(w0 * gammai[ S - candsum  ] +
+			    (alpha-w0)*gammai[ S - first->kappaistar - first->Cjplus ]);
 
-			alphaitilde = (tau-lambda)*(w0 * gammai[ S[i-1] - candsum  ] + 
-			    (alpha-w0)*gammai[ S[i-1] - kappaistar - Cjplus[0] ]);
-			
 		} else {
 
-			alphaitilde = (tau-lambda)*w0*gammai[ S[i-1]-candsum ];
+			alphaitilde = (tau-lambda)*w0*gammai[ S-candsum ];
 
 		}
 
 		alphai[i] = std::min(lambda, alphaitilde);
 		if (pval[i] <= alphai[i]) {
 			R[i] = 1;
-	    //K++;
+		}
+
+		if (stats.on) {
+			// the sum over the rejections and the candidates counted for them
+			double scans = K > 0 ? rejections.size() : 0;
+			stats.test(R[i], scans + updates, K, 3*sizeof(double) +
+				(scans + updates)*sizeof(AddisRejection));
 		}
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 }
@@ -1,45 +1,35 @@
 // [[Rcpp::depends(RcppProgress)]]
 #include <progress.hpp>
 #include <progress_bar.hpp>
+#include "ticker.h"
 #include <algorithm>
+#include <onlineFDR/procedures.h>
+#include "spec.h"
+#include "pending.h"
 
 using namespace Rcpp;
 using std::endl;
 
 // [[Rcpp::export]]
-DataFrame addis_spending_faster(NumericVector pval,
+List addis_spending_faster(NumericVector pval,
 	NumericVector gammai = NumericVector(0),
 	double alpha = 0.05,
 	double lambda = 0.25,
 	double tau = 0.5,
 	bool display_progress = true) {
-	
-	int N = pval.size();
-	NumericVector alphai(N);
-	LogicalVector R(N);
-
-	alphai[0] = alpha * (tau - lambda) * gammai[0];
-	R[0] = (pval[0] <= alphai[0]);
 
-	int selectsum = (pval[0] <= tau);
-	int candsum = (pval[0] <= lambda);
+	onlinefdr::ProcedureSpec s;
+	s.gammai = onlinefdr::GammaSeq(gammai.begin());
+	s.alpha = alpha;
+	s.lambda = lambda;
+	s.tau = tau;
 
-	Progress p(N, display_progress);
-
-	for (int i = 1; i < N; i++) {
-		p.increment();
-		alphai[i] = alpha * (tau - lambda) * gammai[selectsum - candsum];
-		R[i] = (pval[i] <= alphai[i]);
-		selectsum = selectsum + (pval[i] <= tau);
-		candsum = candsum + (pval[i] <= lambda);
-	}
-	return DataFrame::create(_["pval"] = pval,
-		_["alphai"] = alphai,
-		_["R"] = R);
+	onlinefdr::AddisSpending proc(s);
+	return run_sequential(pval, proc, display_progress);
 }
 
 // [[Rcpp::export]]
-DataFrame addis_spending_dep_faster(NumericVector pval,
+List addis_spending_dep_faster(NumericVector pval,
 	IntegerVector L,
 	NumericVector gammai = NumericVector(0),
 	double alpha = 0.05,
@@ -47,9 +37,10 @@ DataFrame addis_spending_dep_faster(NumericVector pval,
 	double tau = 0.5,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 	NumericVector alphai(N);
-	LogicalVector R(N);
+	NumericVector R(N);
 	LogicalVector select(N);
 	LogicalVector cand(N);
 
@@ -57,16 +48,19 @@ DataFrame addis_spending_dep_faster(NumericVector pval,
 	R[0] = (pval[0] <= alphai[0]);
 	select[0] = (pval[0] <= tau);
 	cand[0] = (pval[0] <= lambda);
+	stats.test(R[0], 0, 0, 3*sizeof(double));
 
-	Progress p(N, display_progress);
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 1; i < N; i++) {
-		p.increment();
-		int selectsum = 0;
-		int candsum = 0;
-		int maxL = std::max(0, i - L[i]);
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+		R_xlen_t selectsum = 0;
+		R_xlen_t candsum = 0;
+		R_xlen_t maxL = std::max<R_xlen_t>(0, i - L[i]);
 		if (maxL > 0) {
-			for (int j = 0; j <= maxL; j++) {
+			for (R_xlen_t j = 0; j <= maxL; j++) {
 				if (select[j])
 					selectsum++;
 				if (cand[j])
@@ -74,13 +68,72 @@ DataFrame addis_spending_dep_faster(NumericVector pval,
 			}
 		}
 
-		alphai[i] = alpha * (tau - lambda) * gammai[1 + std::min(L[i]-1, i-1) + selectsum - candsum];
+		alphai[i] = alpha * (tau - lambda) * gammai[1 + std::min<R_xlen_t>(L[i]-1, i-1) + selectsum - candsum];
 		R[i] = (pval[i] <= alphai[i]);
 		select[i] = (pval[i] <= tau);
 		cand[i] = (pval[i] <= lambda);
+		stats.test(R[i], maxL > 0 ? maxL + 1 : 0, 0,
+			3*sizeof(double) + (maxL > 0 ? 2*(maxL + 1)*sizeof(int) : 0));
+	}
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
+		_["alphai"] = alphai,
+		_["R"] = R)));
+}
+
+// With decision times E, the tests whose outcome is not known yet count as
+// selected non-candidates, as the tests within the lag do in the dependent
+// version. The tests wait in a queue until they become known, so each is
+// counted once.
+// [[Rcpp::export]]
+List addis_spending_async_faster(NumericVector pval,
+	IntegerVector E,
+	NumericVector gammai = NumericVector(0),
+	double alpha = 0.05,
+	double lambda = 0.25,
+	double tau = 0.5,
+	bool display_progress = true) {
+
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
+	NumericVector alphai(N);
+	NumericVector R(N);
+
+	onlinefdr::Pending pending;
+	// the known tests, and their selections less their candidates
+	R_xlen_t known = 0, Q = 0;
+
+	alphai[0] = alpha * (tau - lambda) * gammai[0];
+	R[0] = (pval[0] <= alphai[0]);
+	stats.test(R[0], 0, 0, 3*sizeof(double));
+
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
+
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+
+		size_t capacity = pending.capacity();
+		pending.push(i-1, E[i-1]);
+		if (pending.capacity() != capacity)
+			stats.allocate(pending.capacity()*2*sizeof(R_xlen_t));
+
+		double updates = 0;
+		pending.release(i, [&](R_xlen_t j) {
+			known++;
+			Q += (pval[j] <= tau) - (pval[j] <= lambda);
+			updates++;
+		});
+
+		alphai[i] = alpha * (tau - lambda) * gammai[i - known + Q];
+		R[i] = (pval[i] <= alphai[i]);
+		stats.test(R[i], updates, pending.size(), 3*sizeof(double) + updates*2*sizeof(R_xlen_t));
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 }
@@ -0,0 +1,90 @@
+// [[Rcpp::depends(RcppProgress)]]
+#include <progress.hpp>
+#include <progress_bar.hpp>
+#include "ticker.h"
+#include <string>
+#include <onlineFDR/batch.h>
+#include "spec.h"
+
+using namespace Rcpp;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// BatchBH, BatchStBH or BatchPRDS over batches of the given sizes, whose
+// p-values arrive in order. Each batch is decided when its last p-value
+// arrives, from the rejections its open batch keeps up to date. If
+// provisional, also gives the rejections of the open batch (and R^+, but
+// for BatchPRDS) after each arrival; otherwise these vectors are empty.
+// [[Rcpp::export]]
+List batch_faster(NumericVector pval,
+	NumericVector sizes,
+	NumericVector gammai,
+	std::string procedure = "BatchBH",
+	double alpha = 0.05,
+	double lambda = 0.5,
+	bool provisional = false,
+	bool display_progress = true) {
+
+	onlinefdr::BatchProcedure kind;
+	if (procedure == "BatchBH")
+		kind = onlinefdr::BATCH_BH;
+	else if (procedure == "BatchStBH")
+		kind = onlinefdr::BATCH_STBH;
+	else if (procedure == "BatchPRDS")
+		kind = onlinefdr::BATCH_PRDS;
+	else
+		stop("Unknown procedure '%s'.", procedure);
+	if (gammai.size() < sizes.size())
+		stop("gammai must have at least one element per batch.");
+
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
+	NumericVector alphai(N);
+	NumericVector R(N);
+	NumericVector Rprov(provisional ? N : 0);
+	NumericVector Rplusprov(provisional && kind != onlinefdr::BATCH_PRDS ? N : 0);
+
+	onlinefdr::BatchLevels levels(kind, gammai.begin(), alpha);
+
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
+
+	R_xlen_t start = 0;
+	for (R_xlen_t b = 0; b < sizes.size(); b++) {
+		onlinefdr::index_t n = sizes[b];
+		double level = b == 0 ? levels.first() : levels.next(n);
+		onlinefdr::OpenBatch open(kind, n, level, lambda);
+		stats.allocate(open.memory());
+
+		for (onlinefdr::index_t k = 0; k < n; k++) {
+			if (!t.tick())
+				stop("Interrupted by the user.");
+			open.add(pval[start + k]);
+			alphai[start + k] = level;
+			if (provisional) {
+				Rprov[start + k] = open.rejections();
+				if (kind != onlinefdr::BATCH_PRDS)
+					Rplusprov[start + k] = open.rejections_plus();
+			}
+		}
+
+		// the batch is full: its rejections are the p-values up to the
+		// cutoff
+		onlinefdr::index_t rejected = open.rejections();
+		onlinefdr::index_t plus = kind == onlinefdr::BATCH_PRDS ? 0 : open.rejections_plus();
+		double cutoff = open.cutoff(rejected);
+		for (onlinefdr::index_t k = 0; k < n; k++) {
+			R[start + k] = (pval[start + k] <= cutoff);
+			stats.test(R[start + k], 1, n, 3*sizeof(double));
+		}
+		levels.close(level, rejected, plus, open.above_lambda());
+		start += n;
+	}
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(List::create(_["alphai"] = alphai,
+		_["R"] = R,
+		_["R.provisional"] = Rprov,
+		_["Rplus.provisional"] = Rplusprov));
+}
@@ -0,0 +1,138 @@
+#include <Rcpp.h>
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <onlineFDR/sink.h>
+#include "spec.h"
+
+using namespace Rcpp;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// P-values from a numeric vector, or from an R function called with the
+// number wanted. Stops if there are more than the limit, the length of a
+// gammai vector.
+struct ChunkSource {
+	SEXP source;
+	double limit;
+	double read;
+
+	std::size_t operator()(double *buf, std::size_t max) {
+		checkUserInterrupt();
+		NumericVector p;
+		std::size_t n;
+		if (Rf_isFunction(source)) {
+			Function next(source);
+			SEXP got = next((double)max);
+			if (Rf_isNull(got))
+				return 0;
+			p = got;
+			n = p.size();
+			if (n > max)
+				stop("The source returned %.0f p-values, more than the %.0f asked for.",
+					(double)n, (double)max);
+		} else {
+			p = source;
+			n = std::min<double>(max, p.size() - read);
+		}
+		const double *from = p.begin() + (Rf_isFunction(source) ? 0 : (R_xlen_t)read);
+		for (std::size_t k = 0; k < n; k++) {
+			if (!(from[k] >= 0 && from[k] <= 1))
+				stop("All p-values must be between 0 and 1 (p-value %.0f is not).",
+					read + k + 1);
+			buf[k] = from[k];
+		}
+		read += n;
+		if (read > limit)
+			stop("gammai must have at least one element per p-value.");
+		return n;
+	}
+};
+
+// Each chunk as a data frame with columns index, pval, alphai and R, passed
+// to an R function.
+struct FunctionSink {
+	Function f;
+
+	void operator()(const onlinefdr::Chunk &c) {
+		NumericVector index(c.n), pval(c.pval, c.pval + c.n), alphai(c.alphai, c.alphai + c.n),
+			R(c.R, c.R + c.n);
+		for (std::size_t k = 0; k < c.n; k++)
+			index[k] = c.start + k + 1;
+		f(as_frame(List::create(_["index"] = index, _["pval"] = pval,
+			_["alphai"] = alphai, _["R"] = R)));
+	}
+};
+
+struct ChunkRun {
+	ChunkSource source;
+	std::size_t size;
+	SEXP sink;
+	std::string path;
+	onlinefdr::KernelStats *stats;
+	double tests, rejections;
+
+	template <class Proc>
+	void operator()(Proc &proc) {
+		onlinefdr::Counters *c = stats->on ? &stats->counts : nullptr;
+		stats->phase(onlinefdr::KernelStats::RUN);
+		if (path.empty()) {
+			FunctionSink f = {Function(sink)};
+			auto counted = [&](const onlinefdr::Chunk &chunk) {
+				count(chunk);
+				f(chunk);
+			};
+			tests = onlinefdr::run_chunks(proc, source, size, counted, c);
+			return;
+		}
+
+		std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "w"),
+			std::fclose);
+		if (!file)
+			stop("Cannot write '%s'.", path);
+		try {
+			onlinefdr::CsvSink csv(file.get());
+			auto counted = [&](const onlinefdr::Chunk &chunk) {
+				count(chunk);
+				csv(chunk);
+			};
+			tests = onlinefdr::run_chunks(proc, source, size, counted, c);
+		} catch (std::runtime_error &e) {
+			stop("Cannot write '%s'.", path);
+		}
+		if (std::fclose(file.release()) != 0)
+			stop("Cannot write '%s'.", path);
+	}
+
+	void count(const onlinefdr::Chunk &chunk) {
+		for (std::size_t k = 0; k < chunk.n; k++)
+			rejections += chunk.R[k];
+	}
+};
+
+// Runs a procedure over a stream in chunks of size tests, passing each to
+// sink (an R function) or appending it to the CSV file path if not empty.
+// Returns the numbers of tests and rejections.
+// [[Rcpp::export]]
+NumericVector chunks_faster(SEXP source,
+	List spec,
+	SEXP gammai,
+	double size,
+	SEXP sink,
+	std::string path = "") {
+
+	onlinefdr::KernelStats stats;
+	NumericVector table;
+	onlinefdr::ProcedureSpec s = as_spec(spec, as_gamma(gammai, table));
+
+	double limit = Rf_isNewList(gammai) ? R_PosInf : (double)table.size();
+	ChunkRun run = {{source, limit, 0}, (std::size_t)size, sink, path, &stats, 0, 0};
+	if (!onlinefdr::visit_procedure(s, run))
+		stop("Unknown procedure '%s'.", s.procedure);
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(NumericVector::create(_["tests"] = run.tests,
+		_["rejections"] = run.rejections));
+}
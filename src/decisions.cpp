@@ -0,0 +1,89 @@
+// [[Rcpp::depends(RcppProgress)]]
+#include <progress.hpp>
+#include <progress_bar.hpp>
+#include "ticker.h"
+#include <vector>
+#include <climits>
+#include <onlineFDR/procedures.h>
+#include "spec.h"
+
+using namespace Rcpp;
+using std::endl;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// Runs a procedure keeping only its decisions: either the sorted 1-based
+// indices of the rejections or a bitset (bit i%8 of byte i/8 is set when
+// hypothesis i is rejected), and the levels alphai only if asked for.
+struct DecisionsRun {
+	NumericVector pval;
+	bool bits, thresholds, display_progress;
+	RObject result;
+
+	template <class Proc>
+	void operator()(Proc &proc) {
+		onlinefdr::KernelStats stats;
+		R_xlen_t N = pval.size();
+
+		RawVector packed(bits ? (N + 7) / 8 : 0);
+		std::vector<double> index;
+		NumericVector alphai(thresholds ? N : 0);
+
+		onlinefdr::Ticker t(N, display_progress);
+		stats.phase(onlinefdr::KernelStats::RUN);
+
+		for (R_xlen_t i = 0; i < N; i++) {
+			if (!t.tick())
+				stop("Interrupted by the user.");
+			double a;
+			bool rejected = stats.on ? onlinefdr::step(proc, pval[i], a, stats.counts) :
+				onlinefdr::step(proc, pval[i], a);
+			if (thresholds)
+				alphai[i] = a;
+			if (rejected) {
+				if (bits) {
+					packed[i >> 3] |= (Rbyte)(1 << (i & 7));
+				} else {
+					size_t capacity = index.capacity();
+					index.push_back(i + 1);
+					if (index.capacity() != capacity)
+						stats.allocate(index.capacity()*sizeof(double));
+				}
+			}
+		}
+		if (stats.on)
+			stats.counts.touched_bytes += N*(thresholds ? sizeof(double) : 0) +
+				(bits ? (N + 7) / 8 : stats.counts.rejections*sizeof(double));
+
+		stats.phase(onlinefdr::KernelStats::OUTPUT);
+
+		SEXP R;
+		if (bits)
+			R = packed;
+		else if (N <= INT_MAX)
+			R = IntegerVector(index.begin(), index.end());
+		else
+			R = NumericVector(index.begin(), index.end());
+
+		result = stats.attach(RObject(thresholds ?
+			(SEXP)List::create(_["R"] = R, _["alphai"] = alphai) : R));
+	}
+};
+
+// [[Rcpp::export]]
+SEXP decisions_faster(NumericVector pval,
+	List spec,
+	SEXP gammai,
+	bool bits = false,
+	bool thresholds = false,
+	bool display_progress = true) {
+
+	NumericVector table;
+	onlinefdr::ProcedureSpec s = as_spec(spec, as_gamma(gammai, table));
+
+	DecisionsRun run = {pval, bits, thresholds, display_progress, R_NilValue};
+	if (!onlinefdr::visit_procedure(s, run))
+		stop("Unknown procedure '%s'.", s.procedure);
+	return run.result;
+}
@@ -0,0 +1,109 @@
+// [[Rcpp::depends(RcppProgress)]]
+#include <progress.hpp>
+#include <progress_bar.hpp>
+#include "ticker.h"
+#include <string>
+#include <algorithm>
+#include <onlineFDR/mapped.h>
+#include <onlineFDR/procedures.h>
+#include "spec.h"
+
+using namespace Rcpp;
+using std::endl;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// Runs a procedure over a mapped file of doubles, writing the rejections as
+// a bitset (as decisions_faster) and optionally the levels as doubles. The
+// stream is processed in windows whose pages are released once done.
+struct FileRun {
+	const double *pval;
+	long long N;
+	unsigned char *bits;
+	double *alphai;
+	onlinefdr::MappedFile *in, *out, *levels;
+	bool display_progress;
+	long long rejections, invalid;
+	onlinefdr::KernelStats *stats;
+
+	template <class Proc>
+	void operator()(Proc &proc) {
+		const long long window = 1 << 23;
+		onlinefdr::Ticker t(N, display_progress);
+		stats->phase(onlinefdr::KernelStats::RUN);
+
+		for (long long start = 0; start < N; start += window) {
+			long long end = std::min(N, start + window);
+			if (!t.tick(end - start))
+				stop("Interrupted by the user.");
+
+			for (long long i = start; i < end; i++) {
+				double pi = pval[i];
+				if (!(pi >= 0 && pi <= 1)) {
+					invalid = i;
+					return;
+				}
+				double a;
+				bool rejected = stats->on ? onlinefdr::step(proc, pi, a, stats->counts) :
+					onlinefdr::step(proc, pi, a);
+				if (alphai)
+					alphai[i] = a;
+				if (rejected) {
+					bits[i >> 3] |= (unsigned char)(1 << (i & 7));
+					rejections++;
+				}
+			}
+
+			in->release(start * 8, end * 8);
+			out->release(start / 8, end / 8);
+			if (levels)
+				levels->release(start * 8, end * 8);
+		}
+		if (stats->on)
+			stats->counts.touched_bytes += N*(alphai ? sizeof(double) : 0) + (N + 7) / 8;
+	}
+};
+
+// [[Rcpp::export]]
+NumericVector file_faster(std::string input,
+	std::string output,
+	std::string thresholds,
+	List spec,
+	SEXP gammai,
+	bool display_progress = true) {
+
+	onlinefdr::KernelStats stats;
+	NumericVector table;
+	onlinefdr::ProcedureSpec s = as_spec(spec, as_gamma(gammai, table));
+
+	long long N = 0;
+	FileRun run;
+	try {
+		onlinefdr::MappedFile in(input);
+		if (in.size() % 8 != 0)
+			stop("The size of '%s' is not a multiple of 8 bytes.", input);
+		N = in.size() / 8;
+
+		onlinefdr::MappedFile out(output, (N + 7) / 8);
+		std::unique_ptr<onlinefdr::MappedFile> levels;
+		if (!thresholds.empty())
+			levels.reset(new onlinefdr::MappedFile(thresholds, N * 8));
+
+		run = {(const double *)in.begin(), N, (unsigned char *)out.begin(),
+			levels ? (double *)levels->begin() : NULL, &in, &out, levels.get(),
+			display_progress, 0, -1, &stats};
+		if (!onlinefdr::visit_procedure(s, run))
+			stop("Unknown procedure '%s'.", s.procedure);
+	} catch (std::runtime_error &e) {
+		stop(e.what());
+	}
+
+	if (run.invalid >= 0)
+		stop("All p-values must be between 0 and 1 (p-value %.0f is not).",
+			(double)run.invalid + 1);
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(NumericVector::create(_["tests"] = (double)N,
+		_["rejections"] = (double)run.rejections));
+}
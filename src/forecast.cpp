@@ -0,0 +1,42 @@
+#include <Rcpp.h>
+#include <vector>
+#include <onlineFDR/procedures.h>
+#include <onlineFDR/stream.h>
+#include "spec.h"
+
+using namespace Rcpp;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// Restores a saved state if any and tests the history, then gives the
+// levels the next tests would get if their p-values were assumed. From a
+// saved state the history may be empty; each level still gathers over the
+// past rejections, as the procedure is not planned.
+struct ForecastRun {
+	NumericVector pval, assumed, alphai, state;
+
+	template <class Proc>
+	void operator()(Proc &proc) {
+		if (state.size() > 0)
+			proc.restore(std::vector<double>(state.begin(), state.end()));
+		onlinefdr::run(proc, pval.begin(), pval.size(), (double *)nullptr, (double *)nullptr);
+		proc.forecast(assumed.begin(), assumed.size(), alphai.begin());
+	}
+};
+
+// [[Rcpp::export]]
+NumericVector forecast_faster(NumericVector pval,
+	List spec,
+	SEXP gammai,
+	NumericVector assumed,
+	NumericVector state = NumericVector(0)) {
+
+	NumericVector table;
+	onlinefdr::ProcedureSpec s = as_spec(spec, as_gamma(gammai, table));
+
+	ForecastRun run = {pval, assumed, NumericVector(assumed.size()), state};
+	if (!onlinefdr::visit_procedure(s, run))
+		stop("Unknown procedure '%s'.", s.procedure);
+	return run.alphai;
+}
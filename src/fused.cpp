@@ -0,0 +1,105 @@
+// [[Rcpp::depends(RcppProgress)]]
+#include <progress.hpp>
+#include <progress_bar.hpp>
+#include "ticker.h"
+#include <vector>
+#include <algorithm>
+#include <onlineFDR/procedures.h>
+#include "spec.h"
+
+using namespace Rcpp;
+using std::endl;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// [[Rcpp::export]]
+List fused_faster(NumericVector pval,
+	List specs,
+	List gammai,
+	bool display_progress = true) {
+
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
+	int P = specs.size();
+
+	std::vector<NumericVector> tables(P);
+	std::vector<std::unique_ptr<onlinefdr::Procedure>> procs(P);
+
+	// distinct candidate/selection thresholds; 1 (always true) stands for unused
+	std::vector<double> thresholds(1, 1.0);
+	std::vector<int> candk(P), selk(P);
+	auto index_of = [&thresholds](double t) {
+		int k = std::find(thresholds.begin(), thresholds.end(), t) - thresholds.begin();
+		if (k == (int)thresholds.size())
+			thresholds.push_back(t);
+		return k;
+	};
+
+	for (int m = 0; m < P; m++) {
+		SEXP g = gammai[m];
+		onlinefdr::ProcedureSpec s = as_spec(as<List>(specs[m]), as_gamma(g, tables[m]));
+		procs[m] = onlinefdr::make_procedure(s);
+		if (!procs[m])
+			stop("Unknown procedure '%s'.", s.procedure);
+		candk[m] = index_of(procs[m]->candidate());
+		selk[m] = index_of(procs[m]->selection());
+	}
+
+	int T = thresholds.size();
+	const int block = 1024;
+	std::vector<unsigned char> below(T * block);
+
+	// one column per procedure; a list of vectors rather than a matrix so
+	// that each column may be a long vector
+	std::vector<NumericVector> alphai(P);
+	std::vector<NumericVector> R(P);
+	for (int m = 0; m < P; m++) {
+		alphai[m] = NumericVector(N);
+		R[m] = NumericVector(N);
+	}
+
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
+
+	for (R_xlen_t start = 0; start < N; start += block) {
+		int len = std::min<R_xlen_t>(block, N - start);
+		if (!t.tick(len))
+			stop("Interrupted by the user.");
+
+		// indicator streams shared by every procedure using the same threshold
+		for (int k = 0; k < T; k++) {
+			unsigned char *b = &below[k * block];
+			for (int i = 0; i < len; i++)
+				b[i] = (pval[start + i] <= thresholds[k]);
+		}
+		if (stats.on)
+			stats.counts.touched_bytes += T*len*(sizeof(double) + 1);
+
+		for (int i = 0; i < len; i++) {
+			double pi = pval[start + i];
+			for (int m = 0; m < P; m++) {
+				double a;
+				bool rejected;
+				if (stats.on) {
+					// tests every procedure as a separate test
+					rejected = onlinefdr::step(*procs[m], pi, a, stats.counts);
+				} else {
+					a = procs[m]->level();
+					rejected = (pi <= a);
+					procs[m]->observe(a, rejected, below[candk[m] * block + i],
+						below[selk[m] * block + i]);
+				}
+				alphai[m][start + i] = a;
+				R[m][start + i] = rejected;
+			}
+		}
+	}
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	if (stats.on)
+		stats.counts.touched_bytes += 2*(double)N*P*sizeof(double);
+	return stats.attach(List::create(
+		_["alphai"] = wrap(alphai),
+		_["R"] = wrap(R)));
+}
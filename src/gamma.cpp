@@ -0,0 +1,51 @@
+#include <Rcpp.h>
+#include <onlineFDR/gamma.h>
+
+using namespace Rcpp;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// First n terms of a default gamma sequence, multiplied by scale and, if
+// normalise is true, divided by their sum.
+// [[Rcpp::export]]
+NumericVector gamma_sequence(std::string family,
+	double n,
+	double scale = 1,
+	bool normalise = false) {
+
+	int f = onlinefdr::gamma_family(family);
+	if (f < 0)
+		stop("Unknown gamma sequence '%s'.", family);
+	if (n <= 0)
+		return NumericVector(0);
+	R_xlen_t len = n;
+
+	// the registry holds a prefix of the sequence; later terms are computed
+	onlinefdr::GammaFamily g = (onlinefdr::GammaFamily)f;
+	std::shared_ptr<const onlinefdr::GammaTable> t = onlinefdr::gamma_table(g, len);
+	R_xlen_t have = std::min<R_xlen_t>(len, t->value.size());
+
+	if (normalise)
+		scale /= onlinefdr::gamma_total(g, len);
+
+	NumericVector out = no_init(len);
+	if (scale == 1) {
+		std::copy(t->value.begin(), t->value.begin() + have, out.begin());
+	} else {
+		for (R_xlen_t i = 0; i < have; i++)
+			out[i] = scale*t->value[i];
+	}
+	for (R_xlen_t i = have; i < len; i++)
+		out[i] = scale*onlinefdr::gamma_term(g, i + 1.0);
+	return out;
+}
+
+// Sum of the first n terms of a default gamma sequence.
+// [[Rcpp::export]]
+double gamma_total(std::string family, double n) {
+	int f = onlinefdr::gamma_family(family);
+	if (f < 0)
+		stop("Unknown gamma sequence '%s'.", family);
+	return onlinefdr::gamma_total((onlinefdr::GammaFamily)f, n);
+}
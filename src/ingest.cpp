@@ -0,0 +1,277 @@
+#include <Rcpp.h>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <climits>
+#include <onlineFDR/mapped.h>
+#include <onlineFDR/radix.h>
+#include "spec.h"
+
+using namespace Rcpp;
+using std::endl;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// One pass over the p-values for checkPval: bit 1 is set if any is missing,
+// bit 2 if any of the others is outside [0, 1].
+// [[Rcpp::export]]
+int pval_status(NumericVector pval) {
+	int status = 0;
+	for (R_xlen_t i = 0; i < pval.size(); i++) {
+		double p = pval[i];
+		if (std::isnan(p))
+			status |= 1;
+		else if (p < 0 || p > 1)
+			status |= 2;
+	}
+	return status;
+}
+
+// Stable order of dates for checkdf, as 1-based indices, or NULL if they are
+// already sorted. Whole days use a radix sort. If random, the hypotheses of
+// each date are then shuffled as sample.int() does, drawing from R's RNG.
+// [[Rcpp::export]]
+SEXP date_order(NumericVector date, bool random = false) {
+	R_xlen_t N = date.size();
+	bool days = true;
+	for (R_xlen_t i = 0; i < N; i++) {
+		double t = date[i];
+		if (std::isnan(t))
+			stop("One or more dates are not in the correct format.");
+		if (t != std::floor(t) || std::fabs(t) > INT_MAX)
+			days = false;
+	}
+
+	std::vector<std::ptrdiff_t> order;
+	bool sorted;
+	if (days) {
+		std::vector<int> key(date.begin(), date.end());
+		sorted = onlinefdr::radix_order(key, order);
+	} else {
+		sorted = std::is_sorted(date.begin(), date.end());
+		if (!sorted) {
+			order.resize(N);
+			for (R_xlen_t i = 0; i < N; i++)
+				order[i] = i;
+			const double *t = date.begin();
+			std::stable_sort(order.begin(), order.end(),
+				[t](std::ptrdiff_t a, std::ptrdiff_t b) { return t[a] < t[b]; });
+		}
+	}
+	if (sorted && !random)
+		return R_NilValue;
+	if (sorted) {
+		order.resize(N);
+		for (R_xlen_t i = 0; i < N; i++)
+			order[i] = i;
+	}
+
+	NumericVector out(N);
+	if (random) {
+		std::vector<std::ptrdiff_t> x;
+		for (R_xlen_t start = 0, end; start < N; start = end) {
+			end = start + 1;
+			while (end < N && date[order[end]] == date[order[start]])
+				end++;
+			// sampling without replacement as in do_sample
+			R_xlen_t n = end - start;
+			x.resize(n);
+			for (R_xlen_t i = 0; i < n; i++)
+				x[i] = i;
+			for (R_xlen_t i = 0; i < n; i++) {
+				R_xlen_t j = (R_xlen_t)R_unif_index((double)(n - i));
+				out[start + i] = order[start + x[j]] + 1;
+				x[j] = x[n - i - 1];
+			}
+		}
+	} else {
+		for (R_xlen_t i = 0; i < N; i++)
+			out[i] = order[i] + 1;
+	}
+	return out;
+}
+
+// Day number (days since 1970-01-01) of an ISO date YYYY-MM-DD, or NA_INTEGER
+// if the field is not one.
+static int parse_date(const char *b, const char *e) {
+	if (e - b != 10 || b[4] != '-' || b[7] != '-')
+		return NA_INTEGER;
+	int v[3] = {0, 0, 0};
+	const int start[3] = {0, 5, 8}, len[3] = {4, 2, 2};
+	for (int k = 0; k < 3; k++) {
+		for (int c = 0; c < len[k]; c++) {
+			char ch = b[start[k] + c];
+			if (ch < '0' || ch > '9')
+				return NA_INTEGER;
+			v[k] = 10*v[k] + (ch - '0');
+		}
+	}
+	int y = v[0], m = v[1], d = v[2];
+	static const int mdays[12] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+	if (m < 1 || m > 12 || d < 1 || d > mdays[m-1] || (m == 2 && d == 29 && !leap))
+		return NA_INTEGER;
+	// days from civil, proleptic Gregorian calendar
+	y -= m <= 2;
+	int era = (y >= 0 ? y : y - 399) / 400;
+	int yoe = y - era * 400;
+	int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+// Removes surrounding blanks and quotes of a field in place.
+static void trim(const char *&b, const char *&e) {
+	while (b < e && (*b == ' ' || *b == '\t'))
+		b++;
+	while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r'))
+		e--;
+	if (e - b >= 2 && *b == '"' && e[-1] == '"') {
+		b++;
+		e--;
+	}
+}
+
+// Reads an id/date/pval file in one pass over the mapped bytes. Rows with a
+// missing p-value are dropped, and the rows are stably sorted by date.
+// [[Rcpp::export]]
+List read_pvals_faster(std::string path, std::string sep = ",") {
+	if (sep.size() != 1)
+		stop("sep must be a single character.");
+	const char delim = sep[0];
+
+	onlinefdr::MappedFile in(path);
+	const char *p = in.begin(), *end = in.begin() + in.size();
+
+	// splits the next line into fields, honouring quotes
+	std::vector<const char *> fb, fe;
+	auto next_line = [&]() {
+		fb.clear();
+		fe.clear();
+		if (p >= end)
+			return false;
+		const char *b = p;
+		bool quoted = false;
+		for (; p < end; p++) {
+			if (*p == '"')
+				quoted = !quoted;
+			else if (!quoted && (*p == delim || *p == '\n')) {
+				fb.push_back(b);
+				fe.push_back(p);
+				b = p + 1;
+				if (*p == '\n')
+					break;
+			}
+		}
+		if (p == end) {
+			fb.push_back(b);
+			fe.push_back(p);
+		} else {
+			p++;
+		}
+		for (size_t k = 0; k < fb.size(); k++)
+			trim(fb[k], fe[k]);
+		return true;
+	};
+
+	if (!next_line())
+		stop("The file is empty.");
+	int cid = -1, cdate = -1, cpval = -1;
+	for (size_t k = 0; k < fb.size(); k++) {
+		std::string name(fb[k], fe[k]);
+		if (name == "id")
+			cid = k;
+		else if (name == "date")
+			cdate = k;
+		else if (name == "pval")
+			cpval = k;
+	}
+	if (cpval < 0)
+		stop("The dataframe d is missing a column 'pval' of p-values.");
+	size_t ncol = fb.size();
+
+	std::vector<const char *> idb, ide;
+	std::vector<int> day;
+	std::vector<double> pval;
+	double omitted = 0;
+	char buf[64];
+
+	while (next_line()) {
+		if (fb.size() == 1 && fb[0] == fe[0])
+			continue;
+		if (fb.size() != ncol)
+			stop("Line %.0f does not have %d fields.", (double)pval.size() + omitted + 2,
+				(int)ncol);
+
+		const char *b = fb[cpval], *e = fe[cpval];
+		if (b == e || (e - b == 2 && b[0] == 'N' && b[1] == 'A')) {
+			omitted++;
+			continue;
+		}
+		size_t len = std::min<size_t>(e - b, sizeof(buf) - 1);
+		std::copy(b, b + len, buf);
+		buf[len] = 0;
+		char *stop_at;
+		double x = std::strtod(buf, &stop_at);
+		if (stop_at != buf + len || (size_t)(e - b) != len)
+			stop("The vector of p-values contain at least one non-numeric element.");
+		if (std::isnan(x)) {
+			omitted++;
+			continue;
+		}
+		if (x < 0 || x > 1)
+			stop("All p-values must be between 0 and 1.");
+		pval.push_back(x);
+
+		if (cdate >= 0) {
+			int d = parse_date(fb[cdate], fe[cdate]);
+			if (d == NA_INTEGER)
+				stop("One or more dates are not in the correct format.");
+			day.push_back(d);
+		}
+		if (cid >= 0) {
+			idb.push_back(fb[cid]);
+			ide.push_back(fe[cid]);
+		}
+	}
+
+	R_xlen_t N = pval.size();
+	std::vector<std::ptrdiff_t> order;
+	if (cdate < 0 || onlinefdr::radix_order(day, order)) {
+		order.resize(N);
+		for (R_xlen_t i = 0; i < N; i++)
+			order[i] = i;
+	}
+
+	int ncols = (cid >= 0) + (cdate >= 0) + 1, k = 0;
+	List d(ncols);
+	CharacterVector names(ncols);
+	if (cid >= 0) {
+		CharacterVector id(N);
+		for (R_xlen_t i = 0; i < N; i++) {
+			std::ptrdiff_t j = order[i];
+			SET_STRING_ELT(id, i, Rf_mkCharLenCE(idb[j], ide[j] - idb[j], CE_UTF8));
+		}
+		names[k] = "id";
+		d[k++] = id;
+	}
+	if (cdate >= 0) {
+		NumericVector date(N);
+		for (R_xlen_t i = 0; i < N; i++)
+			date[i] = day[order[i]];
+		date.attr("class") = "Date";
+		names[k] = "date";
+		d[k++] = date;
+	}
+	NumericVector pv(N);
+	for (R_xlen_t i = 0; i < N; i++)
+		pv[i] = pval[order[i]];
+	names[k] = "pval";
+	d[k] = pv;
+	d.attr("names") = names;
+
+	return List::create(_["d"] = as_frame(d),
+		_["omitted"] = omitted);
+}
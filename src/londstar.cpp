@@ -1,7 +1,10 @@
 // [[Rcpp::depends(RcppProgress)]]
 #include <progress.hpp>
 #include <progress_bar.hpp>
+#include "ticker.h"
+#include <vector>
 #include <algorithm>
+#include "spec.h"
 
 using namespace Rcpp;
 using std::endl;
@@ -10,118 +13,143 @@ using std::endl;
 // [[Rcpp::plugins(cpp11)]]
 
 // [[Rcpp::export]]
-DataFrame londstar_async_faster(NumericVector pval,
+List londstar_async_faster(NumericVector pval,
 	IntegerVector E,
 	NumericVector betai,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
-	LogicalVector R(N);
+	NumericVector R(N);
 	alphai(0) = betai(0);
 	R(0) = (pval(0) <= alphai(0));
+	stats.test(R(0), 0, 0, 3*sizeof(double));
 
-	Progress p(N * N, display_progress);
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 1; i < N; i++) {
-		int Dsum = 0;
-		for (int j = 0; j <= i-1; j++) {
-			p.increment();
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+		R_xlen_t Dsum = 0;
+		for (R_xlen_t j = 0; j <= i-1; j++) {
 			if (R(j) && (E(j)-1 <= i-1))
 				Dsum++;
 
 		}
-		int D = std::max(Dsum, 1);
+		R_xlen_t D = std::max<R_xlen_t>(Dsum, 1);
 		alphai(i) = betai(i) * D;
 		R(i) = (pval(i) <= alphai(i));
+		stats.test(R(i), i, Dsum, 3*sizeof(double) + i*(sizeof(double) + sizeof(int)));
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 }
 
 // [[Rcpp::export]]
-DataFrame londstar_dep_faster(NumericVector pval,
+List londstar_dep_faster(NumericVector pval,
 	IntegerVector L,
 	NumericVector betai,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
-	LogicalVector R(N);
+	NumericVector R(N);
 	alphai(0) = betai(0);
 	R(0) = (pval(0) <= alphai(0));
+	stats.test(R(0), 0, 0, 3*sizeof(double));
 
-	Progress p(N * N, display_progress);
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 1; i < N; i++) {
-		int Dsum = 0;
-		for (int j = 0; j <= i-1; j++) {
-			p.increment();
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+		R_xlen_t Dsum = 0;
+		for (R_xlen_t j = 0; j <= i-1; j++) {
 			if (R(j) && (j < i - L(i)))
 				Dsum++;
 		}
-		int D = std::max(Dsum, 1);
+		R_xlen_t D = std::max<R_xlen_t>(Dsum, 1);
 		alphai(i) = betai(i) * D;
 		R(i) = (pval(i) <= alphai(i));
+		stats.test(R(i), i, Dsum, 3*sizeof(double) + i*sizeof(double));
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["lag"] = L,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 
 }
 
 // [[Rcpp::export]]
 List londstar_batch_faster(NumericVector pval,
 	IntegerVector batch,
-	IntegerVector batchsum,
+	NumericVector batchsum,
 	NumericVector betai,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
+	onlinefdr::KernelStats stats;
 	int B = batch.size();
+	// batch offsets as 64-bit indices
+	std::vector<R_xlen_t> offset(batchsum.begin(), batchsum.end());
 
 	NumericMatrix alphai(B, max(batch));
 	LogicalMatrix R(B, max(batch));
 
-	for (int i = 0; i < batch(0); i++) {
+	for (R_xlen_t i = 0; i < batch(0); i++) {
 		alphai(0,i) = betai(i);
 		R(0,i) = (pval(i) <= alphai(0,i));
+		stats.test(R(0,i), 0, 0, 3*sizeof(double));
 	}
 
-	int mysum = 0;
-	for (int a = 1; a < batch.size(); a++) {
+	R_xlen_t mysum = 0;
+	for (R_xlen_t a = 1; a < batch.size(); a++) {
 		mysum += batch(a);
 	}
 
-	Progress p(mysum, display_progress);
+	onlinefdr::Ticker t(mysum, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int b = 1; b < B; b++) {
-		int Dsum = 0;
-		for (int j = 0; j <= b-1; j++) {
+	for (R_xlen_t b = 1; b < B; b++) {
+		if (!t.tick(batch(b)))
+			stop("Interrupted by the user.");
+		R_xlen_t Dsum = 0;
+		for (R_xlen_t j = 0; j <= b-1; j++) {
 
-			for (int k = 0; k <= R.ncol()-1; k++) {
+			for (R_xlen_t k = 0; k <= R.ncol()-1; k++) {
 
 				if(R(j,k))
 					Dsum++;
 			}
 		}
-		int D = std::max(Dsum, 1);
-		for (int x = 0; x < batch(b); x++) {
-			p.increment();
-			alphai(b,x) = betai(batchsum(b-1) + x) * D;
-			R(b,x) = (pval(batchsum(b-1) + x) <= alphai(b,x));
+		R_xlen_t D = std::max<R_xlen_t>(Dsum, 1);
+		// the scan of the decisions in the earlier batches
+		if (stats.on) {
+			stats.counts.iterations += b*R.ncol();
+			stats.counts.touched_bytes += b*R.ncol()*sizeof(int);
+		}
+		for (R_xlen_t x = 0; x < batch(b); x++) {
+			alphai(b,x) = betai(offset[b-1] + x) * D;
+			R(b,x) = (pval(offset[b-1] + x) <= alphai(b,x));
+			stats.test(R(b,x), 0, Dsum, 3*sizeof(double));
 		}
 	}
 
-	return List::create(
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(List::create(
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R));
 }
@@ -1,8 +1,11 @@
 // [[Rcpp::depends(RcppProgress)]]
 #include <progress.hpp>
 #include <progress_bar.hpp>
+#include "ticker.h"
 #include <vector>
 #include <algorithm>
+#include <onlineFDR/gather.h>
+#include "spec.h"
 
 using namespace Rcpp;
 using std::endl;
@@ -12,32 +15,40 @@ using std::upper_bound;
 // [[Rcpp::plugins(cpp11)]]
 
 // [[Rcpp::export]]
-DataFrame lordstar_async_faster(NumericVector pval,
+List lordstar_async_faster(NumericVector pval,
 	IntegerVector E,
 	NumericVector gammai,
 	double w0 = 0.005,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
 	NumericVector Rdec(0);
-	LogicalVector R(N);
+	NumericVector R(N);
 	alphai[0] = gammai[0] * w0;
 	R[0] = (pval[0] <= alphai[0]);
 	
 	NumericVector Rdectest(N);
 	Rdectest[1] = 1;
+	stats.test(R[0], 0, 0, 3*sizeof(double));
 	
-	Progress p(N * N, display_progress);
-
-	for (int i = 1; i < N; i++) {
-	  NumericVector r(0);
-	  int cond = 0;
+	// times of the known rejections, reused from test to test
+	std::vector<onlinefdr::index_t> r;
+
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
+
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+	  size_t capacity = r.capacity();
+	  r.clear();
+	  R_xlen_t cond = 0;
 	  
-		for (int j = 0; j <= i-1; j++) {
-			p.increment();
+		for (R_xlen_t j = 0; j <= i-1; j++) {
 		  
 			if (R[j] && (E[j]-1 <= i-1)) {
 				cond += 1;
@@ -47,8 +58,8 @@ DataFrame lordstar_async_faster(NumericVector pval,
 		Rdec.push_back(cond);
 		
 		if(max(Rdec) > 0){
-		  for (int y = 0; y < max(Rdec); y++) {
-		    int z = upper_bound(Rdec.begin(), Rdec.end(), y) - Rdec.begin();
+		  for (R_xlen_t y = 0; y < max(Rdec); y++) {
+		    R_xlen_t z = upper_bound(Rdec.begin(), Rdec.end(), y) - Rdec.begin();
 		    r.push_back(z);
 		  }
 		}
@@ -68,50 +79,62 @@ DataFrame lordstar_async_faster(NumericVector pval,
 
 		} else {
 
-			double gammaisum = 0;
-			int bound = r.size();
-
-			for (int g = 1; g < bound; g++) {
-				gammaisum += gammai[i-r[g]-1];
-			}
+			// gammai[i-r[g]-1] for g >= 1, in the order of the sync kernels
+			double gammaisum = onlinefdr::gather_sum(gammai.begin(), i-1, r.data() + 1,
+				r.size() - 1);
 
 			alphai[i] = gammai[i] * w0 + (alpha - w0) * gammai[i-r[0]-1] + 
 			  alpha * gammaisum;
 			R[i] = (pval[i] <= alphai[i]);
 		}
+
+		if (stats.on) {
+			// the push to Rdec reallocates it, and r grows now and then
+			stats.allocate(i*sizeof(double));
+			if (r.capacity() != capacity)
+				stats.allocate(r.capacity()*sizeof(onlinefdr::index_t));
+			onlinefdr::count_search(stats, i, r.size(), false);
+			stats.test(R[i], i + r.size(), r.size(),
+				3*sizeof(double) + i*(sizeof(double) + sizeof(int)) + r.size()*sizeof(double));
+		}
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 
 }
 
 // [[Rcpp::export]]
-DataFrame lordstar_dep_faster(NumericVector pval,
+List lordstar_dep_faster(NumericVector pval,
 	IntegerVector L,
 	NumericVector gammai,
 	double w0 = 0.005,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
 	NumericVector Rlag(0);
-	LogicalVector R(N);
+	NumericVector R(N);
 	alphai[0] = gammai[0] * w0;
 	R[0] = (pval[0] <= alphai[0]);
+	stats.test(R[0], 0, 0, 3*sizeof(double));
 
-	Progress p(N * N, display_progress);
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 1; i < N; i++) {
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
 	  NumericVector r(0);
-	  int cond = 0;
+	  R_xlen_t cond = 0;
 	  
 	  if (i-1-L[i] >= 0){
-	    for (int j = 0; j < i - L[i]; j++) {
-	      p.increment();
+	    for (R_xlen_t j = 0; j < i - L[i]; j++) {
 	      
 	      if (R[j]){
 	        cond += 1;
@@ -121,8 +144,8 @@ DataFrame lordstar_dep_faster(NumericVector pval,
 	  
 	  Rlag.push_back(cond);
 		
-		for (int y = 0; y < max(Rlag); y++) {
-		  int z = upper_bound(Rlag.begin(), Rlag.end(), y) - Rlag.begin();
+		for (R_xlen_t y = 0; y < max(Rlag); y++) {
+		  R_xlen_t z = upper_bound(Rlag.begin(), Rlag.end(), y) - Rlag.begin();
 		  r.push_back(z);
 		}
 
@@ -142,9 +165,9 @@ DataFrame lordstar_dep_faster(NumericVector pval,
 		} else {
 
 			double gammaisum = 0;
-			int bound = r.size();
+			R_xlen_t bound = r.size();
 
-			for (int g = 1; g < bound; g++) {
+			for (R_xlen_t g = 1; g < bound; g++) {
 				gammaisum += gammai[i-r[g]-1];
 			}
 			
@@ -152,79 +175,102 @@ DataFrame lordstar_dep_faster(NumericVector pval,
 			  alpha * gammaisum;
 			R[i] = (pval[i] <= alphai[i]);
 		}
+
+		if (stats.on) {
+			R_xlen_t scanned = std::max<R_xlen_t>(i - L[i], 0);
+			// the push to Rlag reallocates it
+			stats.allocate(i*sizeof(double));
+			onlinefdr::count_search(stats, i, r.size());
+			stats.test(R[i], scanned + r.size(), r.size(),
+				3*sizeof(double) + (scanned + r.size())*sizeof(double));
+		}
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["lag"] = L,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 
 }
 
 // [[Rcpp::export]]
 List lordstar_batch_faster(NumericVector pval,
 	IntegerVector batch,
-	IntegerVector batchsum,
+	NumericVector batchsum,
 	NumericVector gammai,
 	double w0 = 0.005,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
+	onlinefdr::KernelStats stats;
 	int B = batch.size();
+	// batch offsets as 64-bit indices
+	std::vector<R_xlen_t> offset(batchsum.begin(), batchsum.end());
 
 	NumericMatrix alphai(B, max(batch));
 	LogicalMatrix R(B, max(batch));
 
-	int mysum = 0;
-	for (int a = 1; a < batch.size(); a++) {
+	R_xlen_t mysum = 0;
+	for (R_xlen_t a = 1; a < batch.size(); a++) {
 		mysum += batch[a];
 	}
 
-	Progress p(mysum, display_progress);
+	onlinefdr::Ticker t(mysum, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 0; i < batch[0]; i++) {
+	for (R_xlen_t i = 0; i < batch[0]; i++) {
 		alphai(0,i) = gammai[i] * w0;
 		R(0,i) = (pval[i] <= alphai(0,i));
+		stats.test(R(0,i), 0, 0, 3*sizeof(double));
 	}
 
-	for (int b = 1; b < B; b++) {
+	for (R_xlen_t b = 1; b < B; b++) {
 		NumericVector rcum = cumsum(static_cast<NumericVector>(rowSums(R)));
+		if (stats.on)
+			onlinefdr::count_batch_sums(stats, R.nrow(), R.ncol());
 
-		for (int x = 0; x < batch[b]; x++) {
-			p.increment();
+		for (R_xlen_t x = 0; x < batch[b]; x++) {
+			if (!t.tick())
+				stop("Interrupted by the user.");
 			NumericVector r(0);
 			if (max(rcum) > 0) {
-				for (int y = 0; y < max(rcum); y++) {
-          int z = upper_bound(rcum.begin(), rcum.end(), y) - rcum.begin();
+				for (R_xlen_t y = 0; y < max(rcum); y++) {
+          R_xlen_t z = upper_bound(rcum.begin(), rcum.end(), y) - rcum.begin();
 				  r.push_back(z);
 			  }
 			}
 
 			if(r.size() <= 1) {
 				if(r.size() > 0){
-					alphai(b,x) = gammai[batchsum[b-1] + x] * w0 + (alpha - w0) * 
-					gammai[batchsum[b-1] + x - batchsum[r[0]]];
+					alphai(b,x) = gammai[offset[b-1] + x] * w0 + (alpha - w0) * 
+					gammai[offset[b-1] + x - offset[r[0]]];
 
 				} else {
-					alphai(b,x) = gammai[batchsum[b-1] + x] * w0;
+					alphai(b,x) = gammai[offset[b-1] + x] * w0;
 				}
-				R(b,x) = (pval[batchsum[b-1] + x] <= alphai(b,x));
+				R(b,x) = (pval[offset[b-1] + x] <= alphai(b,x));
 			} else {
 				double gammaisum = 0;
-				int bound = r.size();
-				for (int g = 1; g < bound; g++) {
-					gammaisum += gammai[batchsum[b-1] + x - batchsum[r[g]]];
+				R_xlen_t bound = r.size();
+				for (R_xlen_t g = 1; g < bound; g++) {
+					gammaisum += gammai[offset[b-1] + x - offset[r[g]]];
 				}
-				alphai(b,x) = gammai[batchsum[b-1] + x] * w0 + (alpha - w0) * 
-				gammai[batchsum[b-1] + x - batchsum[r[0]]] + 
+				alphai(b,x) = gammai[offset[b-1] + x] * w0 + (alpha - w0) * 
+				gammai[offset[b-1] + x - offset[r[0]]] + 
 				alpha * gammaisum;
-				R(b,x) = (pval[batchsum[b-1] + x] <= alphai(b,x));
+				R(b,x) = (pval[offset[b-1] + x] <= alphai(b,x));
 			}
 
+			if (stats.on) {
+				onlinefdr::count_search(stats, B, r.size());
+				stats.test(R(b,x), r.size(), r.size(), 3*sizeof(double) + r.size()*sizeof(double));
+			}
 		}
 	}
 
-	return List::create(
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(List::create(
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R));
 }
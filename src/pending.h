@@ -0,0 +1,52 @@
+#ifndef ONLINEFDR_PENDING_H
+#define ONLINEFDR_PENDING_H
+
+#include <Rcpp.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+namespace onlinefdr {
+
+// Tests of an asynchronous stream whose outcomes are not known yet. Test j
+// (from 0) with decision time E (from 1) is known to the tests from
+// max(j+1, E) on. The tests wait in a heap ordered by that time, so the
+// memory is that of the tests in flight rather than of the whole stream.
+class Pending {
+public:
+	void push(R_xlen_t j, R_xlen_t E) {
+		heap.push_back(std::make_pair(std::max(j + 1, E), j));
+		std::push_heap(heap.begin(), heap.end(), later);
+	}
+
+	// Calls known(j) for each test j that is known to test i and was not
+	// known to test i-1, and removes it.
+	template <class F>
+	void release(R_xlen_t i, F &&known) {
+		while (!heap.empty() && heap.front().first <= i) {
+			std::pop_heap(heap.begin(), heap.end(), later);
+			known(heap.back().second);
+			heap.pop_back();
+		}
+	}
+
+	std::size_t size() const {
+		return heap.size();
+	}
+
+	std::size_t capacity() const {
+		return heap.capacity();
+	}
+
+private:
+	typedef std::pair<R_xlen_t, R_xlen_t> Event;
+	static bool later(const Event &a, const Event &b) {
+		return a > b;
+	}
+	std::vector<Event> heap;
+};
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,115 @@
+// [[Rcpp::depends(RcppProgress)]]
+#include <progress.hpp>
+#include <progress_bar.hpp>
+#include "ticker.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include <onlineFDR/procedures.h>
+#include "spec.h"
+
+using namespace Rcpp;
+using std::endl;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// [[Rcpp::export]]
+NumericVector replay_faster(NumericVector pval,
+	IntegerVector batch,
+	List spec,
+	SEXP gammai,
+	int nperm = 100,
+	int seed = 1,
+	int ncores = 1,
+	bool display_progress = true) {
+
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
+	int B = batch.size();
+
+	NumericVector table;
+	onlinefdr::ProcedureSpec s = as_spec(spec, as_gamma(gammai, table));
+	if (!onlinefdr::make_procedure(s))
+		stop("Unknown procedure '%s'.", s.procedure);
+
+	// group boundaries are shared by every permutation
+	std::vector<R_xlen_t> batchsum(B+1);
+	for (int b = 0; b < B; b++)
+		batchsum[b+1] = batchsum[b] + batch[b];
+	if (batchsum[B] != N)
+		stop("The sum of the batch sizes must equal the number of p-values observed.");
+
+	const double *p = pval.begin();
+	std::vector<int> count(N);
+
+	onlinefdr::Ticker prog(nperm, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
+
+#ifdef _OPENMP
+	#pragma omp parallel num_threads(ncores)
+#endif
+	{
+		std::vector<int> local(N);
+		std::vector<R_xlen_t> order(N);
+		onlinefdr::Ticker::Counter ticks(prog);
+		// counted per thread and added up at the end
+		onlinefdr::Counters counts;
+
+#ifdef _OPENMP
+		#pragma omp for schedule(dynamic)
+#endif
+		for (int m = 0; m < nperm; m++) {
+			if (prog.interrupted())
+				continue;
+
+			// seeding per permutation keeps results independent of ncores
+			std::mt19937_64 rng((unsigned long long)seed * 1000003ULL + m);
+			for (R_xlen_t i = 0; i < N; i++)
+				order[i] = i;
+			for (int b = 0; b < B; b++) {
+				for (R_xlen_t k = batchsum[b+1]-1; k > batchsum[b]; k--) {
+					std::uniform_int_distribution<R_xlen_t> pick(batchsum[b], k);
+					std::swap(order[k], order[pick(rng)]);
+				}
+			}
+
+			std::unique_ptr<onlinefdr::Procedure> proc = onlinefdr::make_procedure(s);
+			double alphai;
+			if (stats.on) {
+				for (R_xlen_t i = 0; i < N; i++) {
+					if (onlinefdr::step(*proc, p[order[i]], alphai, counts))
+						local[order[i]]++;
+				}
+			} else {
+				for (R_xlen_t i = 0; i < N; i++) {
+					if (proc->test(p[order[i]], alphai))
+						local[order[i]]++;
+				}
+			}
+			ticks.tick();
+		}
+
+#ifdef _OPENMP
+		#pragma omp critical
+#endif
+		{
+			for (R_xlen_t i = 0; i < N; i++)
+				count[i] += local[i];
+			stats.counts += counts;
+		}
+	}
+
+	if (prog.interrupted())
+		stop("Interrupted by the user.");
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	NumericVector freq(N);
+	for (R_xlen_t i = 0; i < N; i++)
+		freq[i] = (double)count[i] / nperm;
+
+	return stats.attach(freq);
+}
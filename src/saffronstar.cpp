@@ -1,7 +1,10 @@
 // [[Rcpp::depends(RcppProgress)]]
 #include <progress.hpp>
 #include <progress_bar.hpp>
+#include "ticker.h"
 #include <algorithm>
+#include "spec.h"
+#include "pending.h"
 #include <vector>
 
 using namespace Rcpp;
@@ -11,8 +14,13 @@ using std::upper_bound;
 // Enable C++11 via this plugin (Rcpp 0.10.3 or later)
 // [[Rcpp::plugins(cpp11)]]
 
+// The asynchronous kernel keeps the times of the known rejections and the
+// tests in flight rather than vectors over the whole stream. The y-th
+// rejection (from 0) counts from r[y], the test before the first one that
+// knew of more than y rejections, and Cjplus[y] is the number of known
+// candidates after r[y]. Both are kept up to date as tests become known.
 // [[Rcpp::export]]
-DataFrame saffronstar_async_faster(NumericVector pval,
+List saffronstar_async_faster(NumericVector pval,
 	IntegerVector E,
 	NumericVector gammai,
 	double w0 = 0.025,
@@ -20,84 +28,68 @@ DataFrame saffronstar_async_faster(NumericVector pval,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
-	NumericVector Rdec(0);
-	LogicalVector R(N);
-	IntegerVector cand(N);
-	IntegerVector Cjplus(N);
+	NumericVector R(N);
+	std::vector<R_xlen_t> r, Cjplus;
+	onlinefdr::Pending pending;
+	R_xlen_t candsum = 0, known = 0;
 	alphai(0) = std::min((1-lambda)*gammai(0)*w0, lambda);
 	R(0) = (pval(0) <= alphai(0));
+	stats.test(R(0), 0, 0, 3*sizeof(double));
 
-	Progress p(N * N, display_progress);
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 	
-	for (int i = 1; i < N; i++) {
-
-	  int candsum = 0;
-	  
-		cand(i-1) = (pval(i-1) <= lambda);
-
-	  NumericVector r(0);
-	  int cond = 0;
-		
-		for (int j = 0; j <= i-1; j++) {
-		  p.increment();
-		  
-		  candsum += (int)(cand(j) && (E(j)-1 <= i-1));
-		  
-		  if (R(j) && (E(j)-1 <= i-1)) {
-		    cond += 1;
-		  }
-		}
-		
-		Rdec.push_back(cond);
-		
-		if(max(Rdec) > 0){
-		  for (int y = 0; y < max(Rdec); y++) {
-		    int z = upper_bound(Rdec.begin(), Rdec.end(), y) - Rdec.begin();
-		    r.push_back(z);
-		  }
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
+
+		size_t capacity = pending.capacity();
+		pending.push(i-1, E(i-1));
+		if (pending.capacity() != capacity)
+			stats.allocate(pending.capacity()*2*sizeof(R_xlen_t));
+
+		double updates = 0;
+		pending.release(i, [&](R_xlen_t j) {
+			if (pval(j) <= lambda) {
+				candsum++;
+				// a known candidate counts for the rejections before it
+				for (size_t y = 0; y < r.size() && r[y] < j; y++, updates++)
+					Cjplus[y]++;
+			}
+			known += (R_xlen_t)R(j);
+		});
+
+		// rejections that became known to this test count from the last
+		capacity = r.capacity();
+		while ((R_xlen_t)r.size() < known) {
+			r.push_back(i-1);
+			Cjplus.push_back(0);
 		}
+		if (r.capacity() != capacity)
+			stats.allocate(r.capacity()*2*sizeof(R_xlen_t), 2);
 
-		int K = r.size();
+		R_xlen_t K = r.size();
 
 		double alphaitilde;
 		if (K > 1) {
 			
-	    //update Cjplus
 			double Cjplussum = 0;
-			for (int j = 0; j < K; j++) {
-
-				int from = r(j)+1;
-				int to = std::max(i-1, (int)(r(j)+1));
-				int sum = 0;
-
-				for (int k = from; k <= to; k++) {
-					if (cand(k) && E(k)-1 <= i-1)
-						sum++;
-				}
-
-				Cjplus(j) = sum;
-				Cjplussum += gammai(i-r(j)-Cjplus(j)-1);
-			}
+			for (R_xlen_t j = 0; j < K; j++)
+				Cjplussum += gammai(i-r[j]-Cjplus[j]-1);
 			
-			Cjplussum -= gammai(i-r(0)-Cjplus(0)-1);
+			Cjplussum -= gammai(i-r[0]-Cjplus[0]-1);
 
 			alphaitilde = (1-lambda)*(w0*gammai(i-candsum) + (alpha - w0)*
-			gammai(i-r(0)-Cjplus(0)-1) + alpha*Cjplussum);
+			gammai(i-r[0]-Cjplus[0]-1) + alpha*Cjplussum);
 			
 		} else if (K == 1) {
 			
-			int from = r(0)+1;
-			int to = std::max(i-1, (int)(r(0)+1));
-			Cjplus(0) = 0;
-			for (int j = from; j <= to; j++) {
-				if (cand(j) && E(j)-1 <= i-1)
-					Cjplus(0)++;
-			}
 			alphaitilde = (1-lambda)*(w0*gammai(i-candsum) + (alpha-w0)*
-			gammai(i-r(0)-Cjplus(0)-1));
+			gammai(i-r[0]-Cjplus[0]-1));
 			
 		} else {
 			alphaitilde = (1-lambda)*w0*gammai(i-candsum);
@@ -106,15 +98,20 @@ DataFrame saffronstar_async_faster(NumericVector pval,
 		if (pval(i) <= alphai(i)) {
 			R(i) = 1;
 		}
+
+		if (stats.on)
+			stats.test(R(i), K + updates, K, 3*sizeof(double) +
+				(K + updates)*2*sizeof(R_xlen_t));
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 }
 
 // [[Rcpp::export]]
-DataFrame saffronstar_dep_faster(NumericVector pval,
+List saffronstar_dep_faster(NumericVector pval,
 	IntegerVector L,
 	NumericVector gammai,
 	double w0 = 0.025,
@@ -122,27 +119,31 @@ DataFrame saffronstar_dep_faster(NumericVector pval,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 
 	NumericVector alphai(N);
 	NumericVector Rlag(0);
-	LogicalVector R(N);
+	NumericVector R(N);
 	IntegerVector cand(N);
 	IntegerVector Cjplus(N);
 	alphai(0) = std::min((1-lambda)*gammai(0)*w0, lambda);
 	R(0) = (pval(0) <= alphai(0));
+	stats.test(R(0), 0, 0, 3*sizeof(double));
 
-	Progress p(N * N, display_progress);
+	onlinefdr::Ticker t(N, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 1; i < N; i++) {
+	for (R_xlen_t i = 1; i < N; i++) {
+		if (!t.tick())
+			stop("Interrupted by the user.");
 	  
 	  NumericVector r(0);
-	  int cond = 0;
+	  R_xlen_t cond = 0;
 
 		cand(i-1) = (pval(i-1) <= lambda);
 
-		for (int j = 0; j < i - L(i); j++) {
-		  p.increment();
+		for (R_xlen_t j = 0; j < i - L(i); j++) {
 		  
 		  if (R(j)){
 		    cond += 1;
@@ -151,31 +152,31 @@ DataFrame saffronstar_dep_faster(NumericVector pval,
 		
 		Rlag.push_back(cond);
 		
-		for (int y = 0; y < max(Rlag); y++) {
-		  int z = upper_bound(Rlag.begin(), Rlag.end(), y) - Rlag.begin();
+		for (R_xlen_t y = 0; y < max(Rlag); y++) {
+		  R_xlen_t z = upper_bound(Rlag.begin(), Rlag.end(), y) - Rlag.begin();
 		  r.push_back(z);
 		}
 		
-		int bound = i-1-L(i);
-		int candsum = 0;
-		for (int m = 0; m <= bound; m++) {
+		R_xlen_t bound = i-1-L(i);
+		R_xlen_t candsum = 0;
+		for (R_xlen_t m = 0; m <= bound; m++) {
 				candsum += cand(m);
 		}
 		
-		int K = r.size();
+		R_xlen_t K = r.size();
 
 		double alphaitilde;
 		if (K > 1) {
 			
 	    //update Cjplus
 			double Cjplussum = 0;
-			for (int j = 0; j < K; j++) {
+			for (R_xlen_t j = 0; j < K; j++) {
 
-				int from = r(j)+1;
-				int to = std::max(i-1, (int)(r(j)+1));
-				int sum = 0;
+				R_xlen_t from = r(j)+1;
+				R_xlen_t to = std::max(i-1, (R_xlen_t)(r(j)+1));
+				R_xlen_t sum = 0;
 
-				for (int k = from; k <= to; k++) {
+				for (R_xlen_t k = from; k <= to; k++) {
 					if (cand(k) && k < i-L(i))
 						sum++;
 				}
@@ -191,10 +192,10 @@ DataFrame saffronstar_dep_faster(NumericVector pval,
 
 		} else if (K == 1) {
 			
-			int from = r(0)+1;
-			int to = std::max(i-1, (int)(r(0)+1));
+			R_xlen_t from = r(0)+1;
+			R_xlen_t to = std::max(i-1, (R_xlen_t)(r(0)+1));
 			Cjplus(0) = 0;
-			for (int j = from; j <= to; j++) {
+			for (R_xlen_t j = from; j <= to; j++) {
 				if (cand(j) && j < i-L(i))
 					Cjplus(0)++;
 			}
@@ -208,111 +209,137 @@ DataFrame saffronstar_dep_faster(NumericVector pval,
 		if (pval(i) <= alphai(i)) {
 			R(i) = 1;
 		}
+
+		if (stats.on) {
+			R_xlen_t scanned = std::max<R_xlen_t>(i - L(i), 0);
+			// the push to Rlag reallocates it
+			stats.allocate(i*sizeof(double));
+			onlinefdr::count_search(stats, i, K);
+			double rescans = onlinefdr::rescans(r, i-1);
+			stats.test(R(i), 2*scanned + rescans + K, K, 3*sizeof(double) +
+				2*scanned*sizeof(double) + rescans*sizeof(int) + 2*K*sizeof(double));
+		}
 	}
 
-	return DataFrame::create(_["pval"] = pval,
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(as_frame(List::create(_["pval"] = pval,
 		_["lag"] = L,
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R)));
 }
 
 // [[Rcpp::export]]
 List saffronstar_batch_faster(NumericVector pval,
 	IntegerVector batch,
-	IntegerVector batchsum,
+	NumericVector batchsum,
 	NumericVector gammai,
 	double w0 = 0.025,
 	double lambda = 0.5,
 	double alpha = 0.05,
 	bool display_progress = true) {
 
-	int N = pval.size();
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
 	int B = batch.size();
+	// batch offsets as 64-bit indices
+	std::vector<R_xlen_t> offset(batchsum.begin(), batchsum.end());
 	
 	NumericMatrix alphai(B, max(batch));
 	LogicalMatrix R(B, max(batch));
 	IntegerVector cand(N);
 	IntegerVector Cj(B);
 
-	int mysum = 0;
-	for (int a = 1; a < batch.size(); a++) {
+	R_xlen_t mysum = 0;
+	for (R_xlen_t a = 1; a < batch.size(); a++) {
 		mysum += batch(a);
 	}
 
-	Progress p(mysum, display_progress);
+	onlinefdr::Ticker t(mysum, display_progress);
+	stats.phase(onlinefdr::KernelStats::RUN);
 
-	for (int i = 0; i < batch(0); i++) {
+	for (R_xlen_t i = 0; i < batch(0); i++) {
 		cand(i) = (pval(i) <= lambda);
 		alphai(0,i) = (1-lambda)*gammai(i) * w0;
 		R(0,i) = (pval(i) <= alphai(0,i));
+		stats.test(R(0,i), 0, 0, 3*sizeof(double));
 	}
 
 	Cj(0) = sum(cand);
 
-	for (int b = 1; b < B; b++) {
+	for (R_xlen_t b = 1; b < B; b++) {
 		NumericVector rcum = cumsum(static_cast<NumericVector>(rowSums(R)));
 	  
-		int candsum = sum(Cj);
+		R_xlen_t candsum = sum(Cj);
 		NumericVector r(0);
 		
 		if (max(rcum) > 0) {
-		  for (int y = 0; y < max(rcum); y++) {
-		    int z = upper_bound(rcum.begin(), rcum.end(), y) - rcum.begin();
+		  for (R_xlen_t y = 0; y < max(rcum); y++) {
+		    R_xlen_t z = upper_bound(rcum.begin(), rcum.end(), y) - rcum.begin();
 		    r.push_back(z);
 		  }
 		}
 		
-		int K = r.size();
+		R_xlen_t K = r.size();
 		double alphaitilde;
 		
 		IntegerVector Cjplus(K);
+
+		// the sums of candidates in the batches after each rejection
+		double rescans = 0;
+		if (stats.on) {
+			onlinefdr::count_batch_sums(stats, R.nrow(), R.ncol());
+			onlinefdr::count_search(stats, B, K);
+			for (R_xlen_t j = 0; j < K; j++)
+				rescans += std::max<R_xlen_t>(b-1-r(j), 0);
+		}
 		
-		for (int x = 0; x < batch(b); x++) {
-			cand(batchsum(b-1) + x) = (pval(batchsum(b-1) + x) <= lambda);
+		for (R_xlen_t x = 0; x < batch(b); x++) {
+			cand(offset[b-1] + x) = (pval(offset[b-1] + x) <= lambda);
 
-			p.increment();
+			if (!t.tick())
+				stop("Interrupted by the user.");
 			
 			if (K > 1) {
 			  
 	    //update Cjplus
 				double Cjplussum = 0;
-				for (int j = 0; j < K; j++) {
+				for (R_xlen_t j = 0; j < K; j++) {
 
-					int from = r(j)+1;
-					int to = b-1;
-					int sum = 0;
+					R_xlen_t from = r(j)+1;
+					R_xlen_t to = b-1;
+					R_xlen_t sum = 0;
 					
 			
 					if (from <= to){
-					  for (int k = from; k <= to; k++) {
+					  for (R_xlen_t k = from; k <= to; k++) {
 					    sum += Cj(k);
 					  }
 					  Cjplus(j) = sum;
 					} else {
 					  Cjplus(j) = 0;
 					}
-					Cjplussum += gammai(batchsum(b-1) + x - batchsum(r(j)) - Cjplus(j));
+					Cjplussum += gammai(offset[b-1] + x - offset[r(j)] - Cjplus(j));
 				}
 				
-				Cjplussum -= gammai(batchsum(b-1) + x - batchsum(r(0)) - Cjplus(0));
+				Cjplussum -= gammai(offset[b-1] + x - offset[r(0)] - Cjplus(0));
 				
-				alphaitilde = (1-lambda)*(w0*gammai(batchsum(b-1) + x - candsum) + 
-				  (alpha - w0)*gammai(batchsum(b-1) + x - batchsum(r(0)) - Cjplus(0)) + 
+				alphaitilde = (1-lambda)*(w0*gammai(offset[b-1] + x - candsum) + 
+				  (alpha - w0)*gammai(offset[b-1] + x - offset[r(0)] - Cjplus(0)) + 
 				  alpha*Cjplussum);
 				
 				alphai(b,x) = std::min(lambda, alphaitilde);
 				
-				R(b,x) = (pval(batchsum(b-1) + x) <= alphai(b,x));
+				R(b,x) = (pval(offset[b-1] + x) <= alphai(b,x));
 
 			} else if (K == 1) {
 
-				int from = r(0)+1;
-				int to = b-1;
-				int sum = 0;
+				R_xlen_t from = r(0)+1;
+				R_xlen_t to = b-1;
+				R_xlen_t sum = 0;
 				
 				if (from <= to){
 				  
-				  for (int j = from; j <= to; j++) {
+				  for (R_xlen_t j = from; j <= to; j++) {
 				    sum += Cj(j);
 				  }
 				  
@@ -322,24 +349,27 @@ List saffronstar_batch_faster(NumericVector pval,
 				  Cjplus(0) = 0;
 				}
 				
-				alphaitilde = (1-lambda)*(w0*gammai(batchsum(b-1) + x - candsum) + 
-				  (alpha-w0)*gammai(batchsum(b-1) + x - batchsum(r(0)) - Cjplus(0)));
+				alphaitilde = (1-lambda)*(w0*gammai(offset[b-1] + x - candsum) + 
+				  (alpha-w0)*gammai(offset[b-1] + x - offset[r(0)] - Cjplus(0)));
 				
 				alphai(b,x) = std::min(lambda, alphaitilde);
-				R(b,x) = (pval(batchsum(b-1) + x) <= alphai(b,x));
+				R(b,x) = (pval(offset[b-1] + x) <= alphai(b,x));
 
 			} else {
-				alphaitilde = (1-lambda)*w0*gammai(batchsum(b-1) + x - candsum);
+				alphaitilde = (1-lambda)*w0*gammai(offset[b-1] + x - candsum);
 				alphai(b,x) = std::min(lambda, alphaitilde);
-				R(b,x) = (pval(batchsum(b-1) + x) <= alphai(b,x));
+				R(b,x) = (pval(offset[b-1] + x) <= alphai(b,x));
 			}
+
+			stats.test(R(b,x), rescans + K, K,
+				3*sizeof(double) + rescans*sizeof(int) + 2*K*sizeof(double));
 		}
 		
-		int from = batchsum(b-1) + 1;
-		int to = batchsum(b);
-		int sum = 0;
+		R_xlen_t from = offset[b-1] + 1;
+		R_xlen_t to = offset[b];
+		R_xlen_t sum = 0;
 		
-		for (int z = from; z <= to; z++) {
+		for (R_xlen_t z = from; z <= to; z++) {
 		  
 			if(cand(z-1))
 				++sum;
@@ -349,7 +379,8 @@ List saffronstar_batch_faster(NumericVector pval,
 		
 	}
 
-	return List::create(
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(List::create(
 		_["alphai"] = alphai,
-		_["R"] = R);
+		_["R"] = R));
 }
@@ -0,0 +1,24 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <onlineFDR/gather.h>
+
+using namespace Rcpp;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// Instructions used for the sums over past rejections: "portable", "avx2"
+// or "avx512". Lowers (or restores) them to level if given, as far as the
+// CPU supports it, and returns the level in use. The sums do not depend on
+// it, which the tests check by comparing the levels.
+// [[Rcpp::export]]
+std::string simd_level(std::string level = "") {
+	const char *names[] = {"portable", "avx2", "avx512"};
+	if (!level.empty()) {
+		int l = std::find(names, names + onlinefdr::SIMD_LEVELS, level) - names;
+		if (l == onlinefdr::SIMD_LEVELS)
+			stop("Unknown instruction set '%s'.", level);
+		onlinefdr::set_simd_level(l);
+	}
+	return names[onlinefdr::simd_level()];
+}
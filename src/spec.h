@@ -0,0 +1,102 @@
+#ifndef ONLINEFDR_SPEC_H
+#define ONLINEFDR_SPEC_H
+
+#include <Rcpp.h>
+#include <climits>
+#include <progress.hpp>
+#include "ticker.h"
+#include "stats.h"
+#include <onlineFDR/procedures.h>
+#include <onlineFDR/stream.h>
+#include <onlineFDR/gamma.h>
+
+// Converts the gammai argument of a kernel: either a numeric vector or a
+// descriptor list(family, scale) built by gammaFamily() in R. A vector is
+// kept in table, which must outlive the returned sequence.
+inline onlinefdr::GammaSeq as_gamma(SEXP gammai, Rcpp::NumericVector &table) {
+	if (Rf_isNewList(gammai)) {
+		Rcpp::List d(gammai);
+		std::string family = Rcpp::as<std::string>(d["family"]);
+		int f = onlinefdr::gamma_family(family);
+		if (f < 0)
+			Rcpp::stop("Unknown gamma sequence '%s'.", family);
+		return onlinefdr::GammaSeq((onlinefdr::GammaFamily)f, Rcpp::as<double>(d["scale"]));
+	}
+	table = Rcpp::NumericVector(gammai);
+	return onlinefdr::GammaSeq(table.begin());
+}
+
+// Converts a specification built by procedureSpec() in R.
+inline onlinefdr::ProcedureSpec as_spec(Rcpp::List spec, onlinefdr::GammaSeq gammai) {
+	onlinefdr::ProcedureSpec s;
+	s.procedure = Rcpp::as<std::string>(spec["procedure"]);
+	s.version = Rcpp::as<int>(spec["version"]);
+	s.gammai = gammai;
+	s.alpha = Rcpp::as<double>(spec["alpha"]);
+	s.w0 = Rcpp::as<double>(spec["w0"]);
+	s.b0 = Rcpp::as<double>(spec["b0"]);
+	s.lambda = Rcpp::as<double>(spec["lambda"]);
+	s.tau = Rcpp::as<double>(spec["tau"]);
+	s.original = Rcpp::as<bool>(spec["original"]);
+	return s;
+}
+
+// Marks a list of equal-length columns as a data frame in place, so the
+// columns are shared rather than copied by as.data.frame as in
+// DataFrame::create. A data frame cannot have more than INT_MAX rows, so
+// longer results stay plain lists.
+inline Rcpp::List as_frame(Rcpp::List out) {
+	R_xlen_t n = Rf_xlength(out[0]);
+	if (n > INT_MAX)
+		return out;
+	// compact row names, as set by data.frame()
+	if (n > 0)
+		out.attr("row.names") = Rcpp::IntegerVector::create(NA_INTEGER, -(int)n);
+	else
+		out.attr("row.names") = Rcpp::IntegerVector(0);
+	out.attr("class") = "data.frame";
+	return out;
+}
+
+// Result of a kernel over a stream of p-values. R holds the decisions as
+// doubles, which the R wrappers return as they are.
+inline Rcpp::List stream_result(Rcpp::NumericVector pval, Rcpp::NumericVector alphai,
+	Rcpp::NumericVector R) {
+	return as_frame(Rcpp::List::create(Rcpp::_["pval"] = pval,
+		Rcpp::_["alphai"] = alphai,
+		Rcpp::_["R"] = R));
+}
+
+// Runs one procedure over the p-values in order, in blocks driven by the
+// core library. Proc is the concrete type, so the calls in the loop are
+// resolved at compile time. The counting run is a separate loop, taken
+// only when statistics are wanted.
+template <class Proc>
+Rcpp::List run_sequential(Rcpp::NumericVector pval, Proc &proc, bool display_progress) {
+	onlinefdr::KernelStats stats;
+	R_xlen_t N = pval.size();
+
+	Rcpp::NumericVector alphai(N);
+	Rcpp::NumericVector R(N);
+
+	onlinefdr::Ticker t(N, display_progress);
+
+	stats.phase(onlinefdr::KernelStats::RUN);
+	const R_xlen_t block = 4096;
+	for (R_xlen_t start = 0; start < N; start += block) {
+		R_xlen_t len = std::min(block, N - start);
+		if (!t.tick(len))
+			Rcpp::stop("Interrupted by the user.");
+		if (stats.on)
+			onlinefdr::run(proc, pval.begin() + start, len, alphai.begin() + start,
+				R.begin() + start, stats.counts);
+		else
+			onlinefdr::run(proc, pval.begin() + start, len, alphai.begin() + start,
+				R.begin() + start);
+	}
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(stream_result(pval, alphai, R));
+}
+
+#endif
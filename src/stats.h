@@ -0,0 +1,118 @@
+#ifndef ONLINEFDR_KERNEL_STATS_H
+#define ONLINEFDR_KERNEL_STATS_H
+
+// Opt-in instrumentation of the kernels. With options(onlineFDR.stats =
+// TRUE) a kernel times its phases (setup of the outputs and history, the
+// loop over the p-values, and building the result) and counts its work in
+// Counters, then attaches them to its result as the "stats" attribute,
+// which kernelStats() reads. The option is read once per call; when it is
+// off the phases are not timed and the loops count nothing.
+
+#include <Rcpp.h>
+#include <chrono>
+#include <cmath>
+#include <onlineFDR/stats.h>
+
+namespace onlinefdr {
+
+class KernelStats {
+	typedef std::chrono::steady_clock clock;
+
+public:
+	enum Phase { SETUP, RUN, OUTPUT };
+
+	KernelStats() : on(enabled()) {
+		if (on)
+			since = clock::now();
+	}
+
+	static bool enabled() {
+		return Rf_asLogical(Rf_GetOption1(Rf_install("onlineFDR.stats"))) == TRUE;
+	}
+
+	// Ends the current phase and starts p.
+	void phase(Phase p) {
+		if (!on)
+			return;
+		clock::time_point now = clock::now();
+		seconds[current] += std::chrono::duration<double>(now - since).count();
+		since = now;
+		current = p;
+	}
+
+	// Records one test, see Counters::test. Kernels guard the calls with
+	// if (stats.on) where the arguments take work to compute.
+	void test(bool rejected, double iterations, double history, double bytes) {
+		if (!on)
+			return;
+		counts.test(iterations, history, bytes);
+		counts.rejections += rejected;
+	}
+
+	void allocate(double bytes, double n = 1) {
+		if (on)
+			counts.allocate(bytes, n);
+	}
+
+	// Ends the output phase and attaches the statistics to out.
+	template <class T>
+	T attach(T out) {
+		if (!on)
+			return out;
+		phase(OUTPUT);
+		out.attr("stats") = Rcpp::NumericVector::create(
+			Rcpp::_["setup_seconds"] = seconds[SETUP],
+			Rcpp::_["run_seconds"] = seconds[RUN],
+			Rcpp::_["output_seconds"] = seconds[OUTPUT],
+			Rcpp::_["tests"] = counts.tests,
+			Rcpp::_["rejections"] = counts.rejections,
+			Rcpp::_["iterations"] = counts.iterations,
+			Rcpp::_["peak_K"] = counts.peak_history,
+			Rcpp::_["allocations"] = counts.allocations,
+			Rcpp::_["allocated_bytes"] = counts.allocated_bytes,
+			Rcpp::_["touched_bytes"] = counts.touched_bytes);
+		return out;
+	}
+
+	const bool on;
+	Counters counts;
+
+private:
+	clock::time_point since;
+	Phase current = SETUP;
+	double seconds[3] = {0, 0, 0};
+};
+
+// Counts how the star kernels find the K rejection times: a scan for the
+// largest of the seen counts of earlier decisions, a binary search of them
+// per rejection and a push of each time to a vector. A fresh Rcpp vector
+// is reallocated at every push.
+inline void count_search(KernelStats &stats, double seen, double K, bool fresh = true) {
+	double search = K * std::ceil(std::log2(seen + 1));
+	stats.counts.iterations += seen + search;
+	stats.counts.touched_bytes += (seen + search + K)*sizeof(double);
+	if (fresh)
+		stats.allocate(K*(K + 1)/2*sizeof(double), K);
+}
+
+// Iterations of the rescans for Cjplus of the star SAFFRON and ADDIS
+// kernels: from after each rejection time r[j] up to test last.
+template <class V>
+inline double rescans(const V &r, R_xlen_t last) {
+	double n = 0;
+	for (R_xlen_t j = 0; j < (R_xlen_t)r.size(); j++)
+		n += std::max<R_xlen_t>(last, r[j] + 1) - r[j];
+	return n;
+}
+
+// Counts the row sums and cumulative sums of the decisions that the batch
+// kernels recompute before each batch.
+inline void count_batch_sums(KernelStats &stats, double rows, double cols) {
+	stats.counts.iterations += rows*cols + rows;
+	stats.counts.touched_bytes += rows*cols*sizeof(int) + 3*rows*sizeof(double);
+	stats.allocate(2*rows*sizeof(double), 2);
+}
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef ONLINEFDR_TICKER_H
+#define ONLINEFDR_TICKER_H
+
+// Coarse progress reporting and interrupt checks for the kernels. A tick is
+// one unit of outer-loop work (usually one p-value). Ticking only counts;
+// the clock is read once every stride ticks, and the stride doubles while
+// that happens more often than needed, so the cost per tick is an add and
+// a compare. At most every interval seconds the master thread redraws the
+// progress bar (if displayed) and checks for a user interrupt.
+//
+// Worker threads count through their own Ticker::Counter and publish their
+// totals with atomics; only the master thread touches R.
+
+#include <Rcpp.h>
+#include <progress.hpp>
+#include <atomic>
+#include <chrono>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace onlinefdr {
+
+class Ticker {
+	typedef std::chrono::steady_clock clock;
+
+public:
+	Ticker(R_xlen_t total, bool display, double interval = 0.1) : display(display),
+		interval(interval), bar(total, display), own(*this) {}
+
+	class Counter {
+	public:
+		explicit Counter(Ticker &t) : t(t), last(clock::now()) {}
+		~Counter() { t.done += pending; }
+
+		// Counts n units of work. Returns false once the run was interrupted.
+		bool tick(R_xlen_t n = 1) {
+			pending += n;
+			if (pending < stride)
+				return true;
+			return flush();
+		}
+
+	private:
+		bool flush() {
+			t.done += pending;
+			pending = 0;
+			clock::time_point now = clock::now();
+			double elapsed = std::chrono::duration<double>(now - last).count();
+			if (elapsed < t.interval / 4 && stride < (R_xlen_t(1) << 30))
+				stride *= 2;
+			else if (elapsed > t.interval && stride > 1)
+				stride /= 2;
+			last = now;
+			return t.poll(now);
+		}
+
+		Ticker &t;
+		R_xlen_t pending = 0;
+		R_xlen_t stride = 1;
+		clock::time_point last;
+	};
+
+	bool tick(R_xlen_t n = 1) { return own.tick(n); }
+
+	bool interrupted() const { return aborted; }
+
+private:
+	bool poll(clock::time_point now) {
+#ifdef _OPENMP
+		if (omp_get_thread_num() != 0)
+			return !aborted;
+#endif
+		if (std::chrono::duration<double>(now - drawn).count() < interval)
+			return !aborted;
+		drawn = now;
+		if (display)
+			bar.update((unsigned long)done.load());
+		if (Progress::check_abort())
+			aborted = true;
+		return !aborted;
+	}
+
+	bool display;
+	double interval;
+	Progress bar;
+	std::atomic<R_xlen_t> done{0};
+	std::atomic<bool> aborted{false};
+	clock::time_point drawn;
+	Counter own;
+};
+
+} // namespace onlinefdr
+
+#endif
@@ -0,0 +1,53 @@
+#include <Rcpp.h>
+#include <vector>
+#include <onlineFDR/procedures.h>
+#include <onlineFDR/stream.h>
+#include "spec.h"
+
+using namespace Rcpp;
+
+// Enable C++11 via this plugin (Rcpp 0.10.3 or later)
+// [[Rcpp::plugins(cpp11)]]
+
+// Restores a procedure from its saved state (none for a new one), tests the
+// burst and saves the state again, so the cost is that of the burst and of
+// the state rather than of the whole history.
+struct UpdateRun {
+	NumericVector pval, state, alphai, R;
+	onlinefdr::KernelStats *stats;
+
+	template <class Proc>
+	void operator()(Proc &proc) {
+		if (state.size() > 0)
+			proc.restore(std::vector<double>(state.begin(), state.end()));
+		stats->phase(onlinefdr::KernelStats::RUN);
+		if (stats->on)
+			onlinefdr::run(proc, pval.begin(), pval.size(), alphai.begin(), R.begin(),
+				stats->counts);
+		else
+			onlinefdr::run(proc, pval.begin(), pval.size(), alphai.begin(), R.begin());
+		std::vector<double> s = proc.state();
+		state = NumericVector(s.begin(), s.end());
+	}
+};
+
+// [[Rcpp::export]]
+List update_faster(NumericVector pval,
+	List spec,
+	SEXP gammai,
+	NumericVector state) {
+
+	onlinefdr::KernelStats stats;
+	NumericVector table;
+	onlinefdr::ProcedureSpec s = as_spec(spec, as_gamma(gammai, table));
+
+	R_xlen_t N = pval.size();
+	UpdateRun run = {pval, state, NumericVector(N), NumericVector(N), &stats};
+	if (!onlinefdr::visit_procedure(s, run))
+		stop("Unknown procedure '%s'.", s.procedure);
+
+	stats.phase(onlinefdr::KernelStats::OUTPUT);
+	return stats.attach(List::create(_["alphai"] = run.alphai,
+		_["R"] = run.R,
+		_["state"] = run.state));
+}